@@ -0,0 +1,26 @@
+#ifndef CHAR_MASK_HPP
+#define CHAR_MASK_HPP
+
+#include <cstdint>
+
+// letters get a bit each (a-z, folded), digits get a bit each, and every
+// other byte shares one of the remaining 28 bits
+inline uint64_t charBit(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return 1ULL << (c - 'a');
+    if (c >= 'A' && c <= 'Z') return 1ULL << (c - 'A');
+    if (c >= '0' && c <= '9') return 1ULL << (c - '0' + 26);
+    return 1ULL << (36 + c % 28);
+}
+
+// returns a bitmask of the case folded character classes in text
+// an item can only match a query if its mask contains all the bits of the
+// query mask, which is much cheaper to check than match
+inline uint64_t charMask(const char *text, int length) {
+    uint64_t mask = 0;
+    for (int i = 0; i < length; i++) {
+        mask |= charBit(text[i]);
+    }
+    return mask;
+}
+
+#endif
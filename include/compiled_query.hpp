@@ -0,0 +1,46 @@
+#ifndef COMPILED_QUERY_HPP
+#define COMPILED_QUERY_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// a query prepared for scoring
+// it is built once when the query changes, and then shared read only by all
+// scoring threads, so nothing about the query is worked out per item
+
+enum QueryKind {
+    QUERY_EMPTY,        // no words, every item matches
+    QUERY_SINGLE_CHAR,  // one word of one character
+    QUERY_SINGLE_WORD,
+    QUERY_MULTI_WORD,
+};
+
+struct QueryWord {
+    std::string text;
+    int length;
+    uint64_t mask;
+    double frequency;
+};
+
+class CorpusStats;
+
+class CompiledQuery {
+public:
+    CompiledQuery() = default;
+    CompiledQuery(const std::string& query, const CorpusStats& stats);
+
+    const std::vector<QueryWord>& words() const;
+    uint64_t mask() const;
+    QueryKind kind() const;
+    bool empty() const;
+
+private:
+    // words are lowercased, empty words (from repeated spaces) are dropped,
+    // and the rest are ordered so the rarest word is tried first
+    std::vector<QueryWord> m_words;
+    uint64_t m_mask = 0;
+    QueryKind m_kind = QUERY_EMPTY;
+};
+
+#endif
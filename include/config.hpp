@@ -2,6 +2,7 @@
 #define CONFIG_HPP
 
 #include <string>
+#include <vector>
 #include <filesystem>
 #include "ansi_style.hpp"
 #include "style_manager.hpp"
@@ -28,6 +29,7 @@ struct Config {
     std::string activeSelector = "* ";
     std::string query = "";
     std::string logFile = "";
+    std::vector<std::string> inputFiles;
 
     bool showHelp = false;
     bool showHints = false;
@@ -38,6 +40,8 @@ struct Config {
 
     fs::path historyFile;
     int historyLimit = 50;
+    int queryCacheSize = 64;
+    int threads = 0;
 
     int minHintWidth = 25;
     int minHintSpacing = 5;
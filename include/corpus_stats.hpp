@@ -0,0 +1,32 @@
+#ifndef CORPUS_STATS_HPP
+#define CORPUS_STATS_HPP
+
+#include "item_chunk.hpp"
+#include "compiled_query.hpp"
+
+// character and bigram frequencies of the items read so far
+// these are used to guess how many items a query word can match, so that
+// the rarest word of a query is checked first. characters are counted once
+// per item from the item masks, bigrams are counted in every
+// BIGRAM_SAMPLE_RATE'th item, as an estimate only needs the proportions
+
+const int BIGRAM_SAMPLE_RATE = 16;
+
+// a-z (folded), 0-9 and everything else
+const int BIGRAM_CLASSES = 37;
+
+class CorpusStats {
+public:
+    void add(ItemChunk *chunk);
+
+    // returns the estimated fraction of items containing word, from 0 to 1
+    double frequency(const QueryWord& word) const;
+
+private:
+    int m_items = 0;
+    int m_sampledItems = 0;
+    int m_chars[64] = {};
+    int m_bigrams[BIGRAM_CLASSES * BIGRAM_CLASSES] = {};
+};
+
+#endif
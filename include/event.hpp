@@ -14,6 +14,7 @@ enum EventType {
     ALL_ITEMS_READ_EVENT,
     ITEMS_ADDED_EVENT,
     ITEMS_SORTED_EVENT,
+    PAGE_SORTED_EVENT,
     RESIZE_EVENT,
     QUIT_EVENT,
 };
@@ -79,21 +80,11 @@ public:
     }
 };
 
+// the items themselves are passed through an ItemChunkQueue
 class NewItemsEvent : public Event {
-    std::vector<Item>* m_items;
-
-public:
-    NewItemsEvent(std::vector<Item>* items) {
-        m_items = items;
-    }
-
     EventType getType() {
         return NEW_ITEMS_EVENT;
     }
-
-    std::vector<Item>* getItems() {
-        return m_items;
-    }
 };
 
 class AllItemsReadEvent : public Event {
@@ -114,10 +105,31 @@ class ItemsAddedEvent : public Event {
     }
 };
 
+// long scoring passes publish the best items found so far before they are
+// done. progress is the fraction of the pass that was scored, which is 1
+// once the results are final
 class ItemsSortedEvent : public Event {
+    double m_progress;
+
+public:
+    ItemsSortedEvent(double progress = 1) {
+        m_progress = progress;
+    }
+
     EventType getType() {
         return ITEMS_SORTED_EVENT;
     }
+
+    double getProgress() {
+        return m_progress;
+    }
+};
+
+// a page which the ui asked for is sorted, and can replace its placeholders
+class PageSortedEvent : public Event {
+    EventType getType() {
+        return PAGE_SORTED_EVENT;
+    }
 };
 
 class ResizeEvent : public Event {
@@ -6,13 +6,21 @@
 const int BAD_HEURISTIC = -INT_MAX;
 
 // an item represents a single record being queried
-// it is 16 bytes (text (8) + heuristic (4) + index (4))
+// the sorter keeps each field in a separate array (see ItemChunk), and
+// hands out copies of single items to the ui
 
 struct Item {
     // text: what the user searches for
-    // the text may contain a hint after its null terminator
-    // this saves having to store another char pointer (8 bytes each)
-    char *text;
+    // the text is not null terminated, as it may point directly into a memory
+    // mapped input file. the hint (if any) starts one byte after the text,
+    // which saves having to store another char pointer (8 bytes each)
+    const char *text;
+
+    // length: the number of bytes in text
+    int length;
+
+    // hintLength: the number of bytes in the hint
+    int hintLength;
 
     // heuristic: the score of the item based on the current query
     // the heuristic is -INT_MAX if the text fails to match
@@ -23,6 +31,10 @@ struct Item {
     // the index can be negative to push the item to the front
     // eg. if --history is used, recent items will have a negative index
     int index;
+
+    const char* hint() const {
+        return text + length + 1;
+    }
 };
 
 #endif
@@ -9,14 +9,16 @@ class ItemCache {
     public:
         ItemCache(ItemSorter *sorter);
         void refresh();
+        void reload(int i);
         Item* get(int i);
+        bool fetch(int i, Item *item);
         int size();
         int getReserve();
         void setReserve(int n);
 
     private:
         SlidingCache<Item> m_cache;
-        int m_cachedSize;
+        std::shared_ptr<const ItemSnapshot> m_snapshot;
         ItemSorter *m_sorter;
 };
 
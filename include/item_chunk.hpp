@@ -0,0 +1,45 @@
+#ifndef ITEM_CHUNK_HPP
+#define ITEM_CHUNK_HPP
+
+#include "char_mask.hpp"
+#include "item.hpp"
+#include "spsc_queue.hpp"
+
+const int ITEM_CHUNK_BITS = 12;
+const int ITEM_CHUNK_SIZE = 1 << ITEM_CHUNK_BITS;
+
+// the reader hands items to the sorter in fixed size chunks
+// a chunk stores each field of its items in a separate array, so scoring
+// only touches text, length and mask, and sorting only touches heuristic,
+// length and index. the length of the text (and with it, where the hint
+// starts) and the character mask are worked out once while reading
+
+struct ItemChunk {
+    int size = 0;
+    const char *text[ITEM_CHUNK_SIZE];
+    int length[ITEM_CHUNK_SIZE];
+    int hintLength[ITEM_CHUNK_SIZE];
+    int heuristic[ITEM_CHUNK_SIZE];
+    int index[ITEM_CHUNK_SIZE];
+    uint64_t mask[ITEM_CHUNK_SIZE];
+
+    void set(int i, const char *text, int length, int hintLength, int index) {
+        this->text[i] = text;
+        this->length[i] = length;
+        this->hintLength[i] = hintLength;
+        this->heuristic[i] = 0;
+        this->index[i] = index;
+        this->mask[i] = charMask(text, length);
+    }
+
+    Item get(int i) {
+        return {text[i], length[i], hintLength[i], heuristic[i], index[i]};
+    }
+};
+
+// chunks travel from the reader to the sorter through a bounded queue. when
+// the queue is full, the reader has to wait for the sorter to catch up. the
+// sorter keeps the chunks it receives as part of its ItemStore
+typedef SpscQueue<ItemChunk*> ItemChunkQueue;
+
+#endif
@@ -50,6 +50,7 @@ public:
     void moveCursorUp();
     void moveCursorDown();
     void refresh();
+    void reload();
 };
 
 #endif
@@ -1,17 +1,28 @@
 #ifndef ITEM_MATCHER_HPP
 #define ITEM_MATCHER_HPP
 
-#include <vector>
-#include <string>
+#include "compiled_query.hpp"
+#include <cstdint>
+#include <climits>
+
+// marks a word score which has not been worked out yet
+const int UNKNOWN_SCORE = INT_MIN;
 
 class ItemMatcher {
     public:
-        int calc(const char *text, std::vector<std::string>& queries);
+        ItemMatcher(const CompiledQuery& query);
+        int calc(const char *text, int length, uint64_t mask);
+
+        // scores holds the score of each query word, in the order of
+        // CompiledQuery::words. scores that are already known are reused,
+        // and the ones that had to be worked out are filled in
+        int calc(const char *text, int length, uint64_t mask, int *scores);
 
     private:
-        int matchStart(const char *tp, const char *qp);
-        int match(const char *tp, const char *qp, int distance,
-                bool consecutive, int *depth);
+        const CompiledQuery& m_query;
+
+        int scoreChar(const char *text, int length, char c);
+        int score(const char *text, int length, const QueryWord& word);
 };
 
 #endif
@@ -2,18 +2,29 @@
 #define ITEM_READER_HPP
 
 #include <vector>
-#include <stdio.h>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include "item.hpp"
 #include "logger.hpp"
 #include "event_dispatch.hpp"
-#include "double_buffer.hpp"
+#include "item_chunk.hpp"
+#include "text_arena.hpp"
+#include "mapped_file.hpp"
+
+// a part of a mapped file which is split into items on its own thread
+struct LineRange {
+    const char *begin;
+    const char *end;
+    int lines;
+    int firstLine;
+};
 
 class ItemReader : public EventListener {
 public:
-    ItemReader(FILE *file);
+    ItemReader(int fileDescriptor, ItemChunkQueue *queue);
     void setReadHints(bool readHints);
+    bool addInputFile(const std::string& path);
     bool read();
     void onStart();
     void onLoop();
@@ -23,7 +34,6 @@ public:
 private:
     void endInterval();
 
-    bool m_itemsRead = true;
     bool m_intervalPassed = false;
     bool m_intervalActive = false;
 
@@ -31,7 +41,21 @@ private:
 
     int m_itemId;
     bool m_readHints;
-    FILE *m_file;
+    int m_fileDescriptor;
+
+    // files given with --input, which are read instead of stdin
+    std::vector<MappedFile*> m_inputFiles;
+    size_t m_fileIdx = 0;
+    size_t m_fileOffset = 0;
+
+    // stdin is read in large blocks straight into the arena. bytes of a
+    // line which has not been fully read yet sit at the arena's tail
+    TextArena m_arena;
+    size_t m_pending = 0;
+
+    // when reading a regular file, the number of bytes left to read
+    bool m_hasSizeHint = false;
+    size_t m_sizeHint = 0;
 
     EventDispatch& m_dispatch = EventDispatch::instance();
     Logger m_logger = Logger("ItemReader");
@@ -39,13 +63,26 @@ private:
     std::mutex m_intervalMut;
     std::condition_variable m_intervalCv;
 
-    DoubleBuffer<std::vector<Item>> m_itemsBuf;
+    // items are written to m_chunk. full chunks wait in m_pendingChunks
+    // while the queue to the sorter is full
+    ItemChunkQueue *m_queue;
+    ItemChunk *m_chunk = nullptr;
+    std::deque<ItemChunk*> m_pendingChunks;
+    bool m_hasPushedChunks = false;
 
     void intervalThread();
 
     void readFirstBatch();
-    bool readWithHints();
-    bool readWithoutHints();
+    void readSizeHint();
+    bool readStream();
+    bool readMapped();
+    size_t splitMapped(const char *buf, size_t size);
+    void splitRange(LineRange *range, const char *end, ItemChunk **chunks,
+            int base);
+    size_t splitLines(const char *buf, size_t size, bool isEnd);
+    void addItem(const char *text, int length, int hintLength);
+    bool pushChunks();
+    void flushItems();
 };
 
 #endif
@@ -0,0 +1,34 @@
+#ifndef ITEM_SNAPSHOT_HPP
+#define ITEM_SNAPSHOT_HPP
+
+#include "item.hpp"
+#include <vector>
+#include <climits>
+
+// rows of pages which the sorter has not sorted yet are filled in with
+// placeholders until it has. they are drawn, but can't be selected
+inline const char PLACEHOLDER_TEXT[] = "…";
+inline const Item PLACEHOLDER_ITEM = {
+    PLACEHOLDER_TEXT, sizeof(PLACEHOLDER_TEXT) - 1, 0, 0, INT_MAX
+};
+
+inline bool isPlaceholder(const Item& item) {
+    return item.text == PLACEHOLDER_TEXT;
+}
+
+// the results of the sorter as the ui sees them
+// a snapshot is never changed once it is published, so the ui can keep
+// reading one without locking while the sorter works on the next. the items
+// are copies of the first matches, in order. anything past them has to be
+// asked for from the sorter, which only answers for the latest version
+
+struct ItemSnapshot {
+    unsigned version = 0;
+
+    // the number of matches
+    int size = 0;
+
+    std::vector<Item> items;
+};
+
+#endif
@@ -2,17 +2,55 @@
 #define ITEM_SORTER_HPP
 
 #include "item.hpp"
+#include "item_chunk.hpp"
+#include "item_store.hpp"
+#include "item_snapshot.hpp"
+#include "compiled_query.hpp"
+#include "corpus_stats.hpp"
+#include "query_cache.hpp"
+#include "item_matcher.hpp"
 #include "event_dispatch.hpp"
 #include "logger.hpp"
 #include <vector>
+#include <chrono>
 #include <fstream>
 #include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+// the first page of items is kept ready on the sorter thread. it holds at
+// least this many items, or more if the ui can show more at once
+const int FIRST_ITEMS_SIZE = 256;
+
+// below this many items, a comparison sort is quicker than a radix sort
+const int RADIX_SORT_THRESHOLD = 1 << 12;
+
+// candidates are handed to the scoring threads this many at a time
+const int CANDIDATE_GRAIN = 256;
+
+// scoring runs in batches of this many items per thread. between batches,
+// the best items so far are published if the ui has waited long enough
+const int SCORING_BATCH_SIZE = 1 << 16;
+const std::chrono::milliseconds PUBLISH_INTERVAL(16);
+
+// orders item ids by heuristic, then length, then index. without a query,
+// only the index is used
+struct ItemOrder {
+    ItemStore *store;
+    bool isSorted;
+    bool operator()(int l, int r) const;
+};
+
+struct ScoringWorker;
 
 class ItemSorter : public EventListener {
 public:
-    ItemSorter();
-    int size();
-    int copyItems(Item *buffer, int idx, int n);
+    ItemSorter(ItemChunkQueue *queue);
+    void setQueryCacheLimit(size_t bytes);
+    void setFirstPageSize(int n);
+    std::shared_ptr<const ItemSnapshot> snapshot();
+    int copyItems(const ItemSnapshot& snapshot, Item *buffer, int idx, int n);
+    bool fetchItem(int idx, Item *item);
     void onEvent(std::shared_ptr<Event> event);
     void onLoop();
     void onStart();
@@ -23,13 +61,31 @@ private:
     void sorterThread();
     void endSorterThread();
 
+    ItemOrder order();
     void sort(int n);
+    void sortFrom(int begin);
+    bool radixSortOrder(int begin);
+    void placeTopItems(int tail);
+    void addTopCandidates(const std::vector<ScoringWorker>& workers);
+    void publishProgress(const std::vector<ScoringWorker>& workers,
+            size_t scored);
+    void publishSnapshot(const int *ids, int n, int size, double progress);
     void setQuery();
-    void calcHeuristics(bool queryChanged);
-    void calcHeuristics(bool newItems, int start, int end);
+    bool calcHeuristics();
+    void orderByIndex();
+    Item getItem(int id);
+    bool cancelled() const;
+    void prepareWordScores();
+    int calcItem(ItemMatcher& matcher, int id, int *scores);
+    bool calcChunks(int start, int end);
+    bool calcCandidates();
+
+    void requestPage(unsigned version, int end);
+    bool sortPage();
+    bool resizeFirstPage();
 
-    void addNewItems();
-    void sortItems();
+    bool addNewItems();
+    void sortItems(bool itemsAdded);
 
     EventDispatch& m_dispatch = EventDispatch::instance();
     Logger m_logger = Logger("ItemSorter");
@@ -39,20 +95,68 @@ private:
 
     std::mutex m_items_mut;
 
+    ItemChunkQueue *m_queue;
     bool m_hasNewItems = false;
-    std::vector<Item> *m_newItems;
 
-    int m_heuristicIdx;
+    // the number of chunks in the store which have been scored for the
+    // current query
+    int m_heuristicChunks;
+
+    // m_narrow is set when the query was extended, and m_order still needs
+    // to be narrowed down. m_heuristicsDone is set once m_order is complete
+    // for the current query, so that it can be cached
+    bool m_narrow = false;
+    bool m_heuristicsDone = false;
+    QueryCache m_queryCache;
+
+    // the score of each query word for every item, indexed by item id
+    std::unordered_map<std::string, std::vector<int>> m_wordScores;
+    std::vector<int*> m_wordColumns;
+
+    // the best items handed in by the scoring threads
+    std::vector<int> m_topCandidates;
     int m_sortIdx;
 
-    Item m_firstItems[256];
-    int m_firstItemsSize = 0;
+    // the number of items in the first page. the ui can change it at any
+    // time through m_nextFirstPageSize, which is guarded by m_sorter_mut. it
+    // is picked up at the start of each pass, or right away if the sorter
+    // is idle
+    int m_nextFirstPageSize = FIRST_ITEMS_SIZE;
+    int m_firstPageSize = FIRST_ITEMS_SIZE;
+
+    // the latest snapshot for the ui. m_orderVersion is the version of the
+    // snapshot m_order belongs to, or 0 while a pass is changing it
+    std::atomic<std::shared_ptr<const ItemSnapshot>> m_snapshot;
+    unsigned m_version = 0;
+    unsigned m_orderVersion = 0;
 
-    std::vector<Item> m_items;
+    // the ui asks for m_order to be sorted up to m_pageEnd for the snapshot
+    // with version m_pageVersion. both are guarded by m_sorter_mut
+    int m_pageEnd = 0;
+    unsigned m_pageVersion = 0;
+
+    // how many of the items in the current pass have been scored, and when
+    // the first items were last published
+    size_t m_passScored = 0;
+    size_t m_passSize = 0;
+    std::chrono::steady_clock::time_point m_lastPublish;
+
+    // m_order holds the id of every item in the first m_heuristicChunks
+    // chunks which matches the current query, sorted up to m_sortIdx
+    ItemStore m_store;
+    std::vector<int> m_order;
+    CorpusStats m_stats;
     bool m_isSorted;
     std::string m_query;
+    CompiledQuery m_compiledQuery;
     bool m_queryChanged;
     std::string m_newQuery;
+
+    // m_epoch is bumped whenever the work in flight goes stale (new query or
+    // quit). m_passEpoch is the epoch the current pass started with, so the
+    // scoring threads can poll for cancellation without taking a lock
+    std::atomic<unsigned> m_epoch = 0;
+    unsigned m_passEpoch = 0;
 };
 
 #endif
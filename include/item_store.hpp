@@ -0,0 +1,43 @@
+#ifndef ITEM_STORE_HPP
+#define ITEM_STORE_HPP
+
+#include "item_chunk.hpp"
+#include <atomic>
+
+// an item id is the number of the chunk holding the item, followed by the
+// item's position in that chunk (the lowest ITEM_CHUNK_BITS bits)
+const int MAX_ITEM_CHUNKS = 1 << (31 - ITEM_CHUNK_BITS);
+
+// all items, made up of the chunks sent by the reader
+// the store only grows by adding whole chunks, and the table of chunks has a
+// fixed capacity, so an item never moves once added. other threads can keep
+// reading items while new chunks arrive. only the sorter thread adds chunks
+
+class ItemStore {
+public:
+    ItemStore();
+    ~ItemStore();
+    void add(ItemChunk *chunk);
+    int numChunks();
+    ItemChunk** getChunks();
+    int size();
+
+    ItemChunk* getChunk(int id) {
+        return m_chunks[id >> ITEM_CHUNK_BITS];
+    }
+
+    static int getOffset(int id) {
+        return id & (ITEM_CHUNK_SIZE - 1);
+    }
+
+    Item get(int id) {
+        return getChunk(id)->get(getOffset(id));
+    }
+
+private:
+    ItemChunk **m_chunks;
+    std::atomic<int> m_numChunks = 0;
+    std::atomic<int> m_size = 0;
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// a read only memory mapping of an input file
+// items read from the file point straight into the mapping, so the file's
+// contents are never copied
+
+class MappedFile {
+public:
+    ~MappedFile();
+    bool open(const std::string& path);
+    bool open(int fileDescriptor);
+    const char* data();
+    size_t size();
+
+private:
+    char *m_data = nullptr;
+    size_t m_size = 0;
+};
+
+#endif
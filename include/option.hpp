@@ -2,6 +2,7 @@
 #define OPTION_HPP
 
 #include <string>
+#include <vector>
 #include <optional>
 
 class Option {
@@ -36,6 +37,15 @@ class StringOption : public Option {
         bool m_allowEmpty;
 };
 
+class StringListOption : public Option {
+    public:
+        StringListOption(std::string key, std::vector<std::string> *values);
+        bool parse(const char *value);
+
+    private:
+        std::vector<std::string> *m_values;
+};
+
 class IntegerOption : public Option {
     public:
         IntegerOption(std::string key, int *value);
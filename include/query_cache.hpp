@@ -0,0 +1,48 @@
+#ifndef QUERY_CACHE_HPP
+#define QUERY_CACHE_HPP
+
+#include "item_store.hpp"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+
+// the results of recent queries, so that going back to an earlier query
+// (eg. with backspace) does not have to score every item again
+// an entry holds the matching ids and their heuristics for the first chunks
+// of the store. the least recently used entries are dropped once the cache
+// grows past its limit
+
+struct QueryCacheEntry {
+    std::string query;
+    int chunks;
+    int sorted;
+    std::vector<int> ids;
+    std::vector<int> heuristics;
+};
+
+class QueryCache {
+public:
+    void setLimit(size_t bytes);
+
+    // stores the matches of query over the first chunks of the store, of
+    // which the first sorted ids are in order
+    void put(const std::string& query, int chunks, int sorted,
+             ItemStore& store, const std::vector<int>& ids);
+
+    // returns the entry of the longest cached query which query starts with,
+    // or nullptr. the matches of query are always a subset of its matches
+    const QueryCacheEntry* find(const std::string& query);
+
+private:
+    static size_t entrySize(const std::string& query, size_t n);
+    void evict(size_t size);
+
+    std::list<QueryCacheEntry> m_entries;
+    std::unordered_map<std::string,
+        std::list<QueryCacheEntry>::iterator> m_index;
+    size_t m_size = 0;
+    size_t m_limit = 0;
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// sorts values by their keys (lowest first), looking at the lowest bits
+// bits of each key, one byte per pass. the sort is stable, and bytes that
+// are the same in every key are skipped. large inputs are split into slices
+// for the thread pool, and each slice is counted and scattered on its own
+void radixSort(uint64_t *keys, int *values, size_t n, int bits);
+
+#endif
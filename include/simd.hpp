@@ -0,0 +1,21 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cstddef>
+
+// vectorized scanning kernels
+// on x86 these use SSE2, or AVX2 when the cpu supports it. the best variant
+// is picked once at startup, so callers never need to check cpu features
+
+// returns a pointer to the first '\n' in [begin, end), or nullptr
+const char* findNewline(const char *begin, const char *end);
+
+// returns the number of '\n' in [begin, end)
+size_t countNewlines(const char *begin, const char *end);
+
+// returns true if every character of the null terminated query appears in
+// [begin, end) in order, with uppercase ascii letters in the text folded to
+// lowercase before comparing
+bool isSubsequence(const char *begin, const char *end, const char *query);
+
+#endif
@@ -60,6 +60,17 @@ class SlidingCache {
             refresh(0);
         }
 
+        // loads the window around offset again
+        void refresh(int offset) {
+            int roundedOffset = offset - mod(offset, m_reserve);
+            int n = m_datasource(m_cache, roundedOffset, m_reserve);
+            if (n > 0) {
+                m_idx = 0;
+                m_offset = roundedOffset;
+                m_size = m_offset + n;
+            }
+        }
+
         int getReserve() {
             return m_reserve;
         }
@@ -80,16 +91,6 @@ class SlidingCache {
         int m_idx;
         std::function<int(T *buffer, int idx, int n)> m_datasource;
 
-        void refresh(int offset) {
-            int roundedOffset = offset - mod(offset, m_reserve);
-            int n = m_datasource(m_cache, roundedOffset, m_reserve);
-            if (n > 0) {
-                m_idx = 0;
-                m_offset = roundedOffset;
-                m_size = m_offset + n;
-            }
-        }
-
         int loadData(int offset, int amount) {
             return m_datasource(m_cache + m_idx, offset, amount);
         }
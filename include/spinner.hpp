@@ -13,6 +13,7 @@ class Spinner {
     bool m_firstUpdateComplete = false;
     int m_frame = 0;
     bool m_isSpinning = false;
+    double m_progress = 0;
     std::chrono::time_point<std::chrono::system_clock> m_lastFrameTime =
             std::chrono::system_clock::now();
 
@@ -26,6 +27,10 @@ public:
     void draw();
     bool isSpinning();
     void setSpinning(bool value);
+
+    // while a fraction between 0 and 1 is set, a filling glyph is drawn
+    // instead of the animation
+    void setProgress(double progress);
 };
 
 #endif
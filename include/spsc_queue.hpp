@@ -0,0 +1,53 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <vector>
+
+// a bounded, lock free queue for exactly one producer thread and one
+// consumer thread. push fails when the queue is full and pop fails when it
+// is empty, so neither side ever blocks the other
+
+template <class T>
+class SpscQueue {
+    public:
+        SpscQueue(int capacity) {
+            // one slot is always left empty to tell a full queue apart from
+            // an empty one
+            m_size = capacity + 1;
+            m_buffer.resize(m_size);
+        }
+
+        bool push(const T& value) {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            size_t next = (tail + 1) % m_size;
+            if (next == m_head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            m_buffer[tail] = value;
+            m_tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T *value) {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            *value = m_buffer[head];
+            m_head.store((head + 1) % m_size, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::vector<T> m_buffer;
+        size_t m_size;
+
+        // the producer writes the tail and the consumer writes the head.
+        // they are kept on separate cache lines so the two threads do not
+        // keep invalidating each other's cache
+        alignas(64) std::atomic<size_t> m_head = 0;
+        alignas(64) std::atomic<size_t> m_tail = 0;
+};
+
+#endif
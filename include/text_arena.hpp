@@ -0,0 +1,38 @@
+#ifndef TEXT_ARENA_HPP
+#define TEXT_ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+// a bump allocator for item text
+// items live until jfind exits, so instead of one heap allocation per line,
+// text is carved out of a few large blocks. this avoids the malloc header on
+// every item, keeps neighbouring items next to each other in memory, and
+// turns teardown into a handful of frees
+
+const size_t TEXT_ARENA_BLOCK_SIZE = 4 << 20;
+
+class TextArena {
+public:
+    ~TextArena();
+    char* alloc(size_t size);
+
+    // the free space at the end of the current block can be written to
+    // directly (eg. by read(2)) and claimed afterwards with commit
+    char* tail();
+    size_t available();
+    void commit(size_t size);
+
+    // makes sure at least size bytes are available. if a new block is
+    // needed, the first keep bytes of the old tail are moved into it
+    void reserve(size_t size, size_t keep);
+
+private:
+    void newBlock(size_t size, size_t keep);
+
+    std::vector<char*> m_blocks;
+    char *m_ptr = nullptr;
+    char *m_end = nullptr;
+};
+
+#endif
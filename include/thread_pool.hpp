@@ -0,0 +1,72 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of worker threads, started once and shared by everything that
+// splits work between threads
+//
+// run splits [0, n) into one range per thread, and every thread works
+// through its own range a few entries (the grain) at a time. a thread that
+// runs out of work takes grains from the ranges of the others, so a few
+// slow entries (eg. very long lines) can't hold up the whole job
+//
+// jobs started while the pool is busy are queued. their caller starts on
+// them right away, and the workers join in once the jobs before them have
+// no work left to hand out. a job started from inside a task (ie. from a
+// thread already working on a job) is run by that thread alone
+
+class ThreadPool {
+public:
+    // the task is given the number of the thread running it, which is less
+    // than numThreads and unique among the threads working on the same job,
+    // and a part of the range to work on
+    typedef std::function<void(int thread, size_t begin, size_t end)> Task;
+
+    static ThreadPool& instance();
+
+    void setNumThreads(int n);
+    int numThreads();
+    void run(size_t n, size_t grain, Task task);
+
+private:
+    ThreadPool();
+    void startThreads();
+    void stopThreads();
+    void workerThread(int thread);
+
+    struct alignas(64) Range {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    struct Job {
+        Task task;
+        size_t grain;
+        std::unique_ptr<Range[]> ranges;
+        int active = 0;          // workers inside the job
+        bool exhausted = false;  // every grain has been handed out
+    };
+
+    void work(Job& job, int thread);
+
+    int m_nThreads;
+    std::vector<std::thread> m_threads;
+
+    std::shared_mutex m_runMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_doneCv;
+    std::deque<Job*> m_jobs;
+    bool m_stop = false;
+};
+
+#endif
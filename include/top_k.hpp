@@ -0,0 +1,42 @@
+#ifndef TOP_K_HPP
+#define TOP_K_HPP
+
+#include <vector>
+#include <algorithm>
+
+// keeps the best k values added to it, where a is better than b if
+// compare(a, b). the values are kept in a heap with the worst of them on
+// top, so a value which does not make the cut costs a single comparison
+
+template <class T, class Compare>
+class TopK {
+    public:
+        TopK(int k, Compare compare) : m_compare(compare) {
+            m_k = k;
+            m_heap.reserve(k);
+        }
+
+        void add(const T& value) {
+            if (m_heap.size() < m_k) {
+                m_heap.push_back(value);
+                std::push_heap(m_heap.begin(), m_heap.end(), m_compare);
+            }
+            else if (m_k > 0 && m_compare(value, m_heap.front())) {
+                std::pop_heap(m_heap.begin(), m_heap.end(), m_compare);
+                m_heap.back() = value;
+                std::push_heap(m_heap.begin(), m_heap.end(), m_compare);
+            }
+        }
+
+        // the values in no particular order
+        const std::vector<T>& values() const {
+            return m_heap;
+        }
+
+    private:
+        std::vector<T> m_heap;
+        size_t m_k;
+        Compare m_compare;
+};
+
+#endif
@@ -42,6 +42,7 @@ private:
     std::vector<KeyEvent> m_inputQueue;
 
     bool m_requiresRefresh;
+    bool m_requiresReload = false;
     bool m_isSorting = false;
     bool m_isReading = true;
 
@@ -0,0 +1,70 @@
+#include "../include/compiled_query.hpp"
+#include "../include/char_mask.hpp"
+#include "../include/corpus_stats.hpp"
+#include "../include/util.hpp"
+#include <algorithm>
+
+CompiledQuery::CompiledQuery(const std::string& query,
+                             const CorpusStats& stats)
+{
+    for (std::string& word : split(query, ' ')) {
+        if (word.empty()) {
+            continue;
+        }
+        // text is folded to lowercase when matching, so an uppercase
+        // character in the query could never match
+        for (char& c : word) {
+            if (c >= 'A' && c <= 'Z') {
+                c += 32;
+            }
+        }
+        uint64_t mask = charMask(word.c_str(), word.size());
+        QueryWord queryWord = {word, (int)word.size(), mask, 1};
+        queryWord.frequency = stats.frequency(queryWord);
+        m_words.push_back(queryWord);
+        m_mask |= mask;
+    }
+
+    // checking the word that matches the fewest items first rejects most
+    // items sooner. without statistics to go by, a longer word with more
+    // distinct characters is assumed to be rarer
+    std::stable_sort(m_words.begin(), m_words.end(),
+            [] (const QueryWord& l, const QueryWord& r) {
+        if (l.frequency != r.frequency) {
+            return l.frequency < r.frequency;
+        }
+        if (l.length == r.length) {
+            return __builtin_popcountll(l.mask) > __builtin_popcountll(r.mask);
+        }
+        return l.length > r.length;
+    });
+
+    if (m_words.empty()) {
+        m_kind = QUERY_EMPTY;
+    }
+    else if (m_words.size() > 1) {
+        m_kind = QUERY_MULTI_WORD;
+    }
+    else if (m_words[0].length == 1) {
+        m_kind = QUERY_SINGLE_CHAR;
+    }
+    else {
+        m_kind = QUERY_SINGLE_WORD;
+    }
+}
+
+const std::vector<QueryWord>& CompiledQuery::words() const {
+    return m_words;
+}
+
+uint64_t CompiledQuery::mask() const {
+    return m_mask;
+}
+
+QueryKind CompiledQuery::kind() const {
+    return m_kind;
+}
+
+bool CompiledQuery::empty() const {
+    return m_kind == QUERY_EMPTY;
+}
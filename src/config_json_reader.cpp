@@ -16,6 +16,10 @@ std::map<std::string, JsonReaderStrategy*> ConfigJsonReader::createOptions() {
             new JsonIntReaderStrategy(&m_config.promptGap))->min(0);
     options["history_limit"] = (
             new JsonIntReaderStrategy(&m_config.historyLimit))->min(0);
+    options["query_cache_size"] = (
+            new JsonIntReaderStrategy(&m_config.queryCacheSize))->min(0);
+    options["threads"] = (
+            new JsonIntReaderStrategy(&m_config.threads))->min(0);
     options["min_hint_spacing"] = (
             new JsonIntReaderStrategy(&m_config.minHintSpacing))->min(0);
     options["min_hint_width"] = (
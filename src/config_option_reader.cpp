@@ -14,7 +14,11 @@ bool ConfigOptionReader::read(int argc, const char **argv) {
         new StringOption("query", &m_config.query),
         new StringOption("history", &historyFile),
         new StringOption("log", &m_config.logFile),
-        (new IntegerOption("history-limit", &m_config.historyLimit))->min(0)
+        new StringListOption("input", &m_config.inputFiles),
+        (new IntegerOption("history-limit", &m_config.historyLimit))->min(0),
+        (new IntegerOption("query-cache-size",
+                           &m_config.queryCacheSize))->min(0),
+        (new IntegerOption("threads", &m_config.threads))->min(0)
     }};
 
     OptionParser optionParser(options);
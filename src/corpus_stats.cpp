@@ -0,0 +1,50 @@
+#include "../include/corpus_stats.hpp"
+#include "../include/char_mask.hpp"
+#include <algorithm>
+
+static int bigramClass(char c) {
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= '0' && c <= '9') return c - '0' + 26;
+    return BIGRAM_CLASSES - 1;
+}
+
+void CorpusStats::add(ItemChunk *chunk) {
+    for (int i = 0; i < chunk->size; i++) {
+        for (uint64_t mask = chunk->mask[i]; mask; mask &= mask - 1) {
+            m_chars[__builtin_ctzll(mask)]++;
+        }
+        if ((m_items + i) % BIGRAM_SAMPLE_RATE) {
+            continue;
+        }
+        const char *text = chunk->text[i];
+        for (int j = 1; j < chunk->length[i]; j++) {
+            m_bigrams[bigramClass(text[j - 1]) * BIGRAM_CLASSES
+                + bigramClass(text[j])]++;
+        }
+        m_sampledItems++;
+    }
+    m_items += chunk->size;
+}
+
+double CorpusStats::frequency(const QueryWord& word) const {
+    if (m_items == 0) {
+        return 1;
+    }
+    // a word can't be in more items than its rarest character or bigram.
+    // bigrams are counted per occurrence, so they only give an estimate
+    double freq = 1;
+    const char *text = word.text.c_str();
+    for (int i = 0; i < word.length; i++) {
+        uint64_t bit = charMask(text + i, 1);
+        freq = std::min(freq, (double)m_chars[__builtin_ctzll(bit)] / m_items);
+    }
+    if (m_sampledItems > 0) {
+        for (int i = 1; i < word.length; i++) {
+            int bigram = bigramClass(text[i - 1]) * BIGRAM_CLASSES
+                + bigramClass(text[i]);
+            freq = std::min(freq, (double)m_bigrams[bigram] / m_sampledItems);
+        }
+    }
+    return freq;
+}
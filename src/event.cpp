@@ -7,6 +7,7 @@ const char *EVENT_NAMES[] = {
     "ALL_ITEMS_READ_EVENT",
     "ITEMS_ADDED_EVENT",
     "ITEMS_SORTED_EVENT",
+    "PAGE_SORTED_EVENT",
     "RESIZE_EVENT",
     "QUIT_EVENT",
 };
@@ -1,6 +1,5 @@
 #include "../include/history_manager.hpp"
 #include "../include/util.hpp"
-#include "../include/thread_manager.hpp"
 #include <fstream>
 #include <iostream>
 
@@ -35,7 +34,7 @@ bool HistoryManager::readHistory() {
 
 void HistoryManager::applyHistory(Item *item) {
     std::unordered_map<std::string, int>::const_iterator it
-        = m_historyLookup.find(item->text);
+        = m_historyLookup.find(std::string(item->text, item->length));
     if (it != m_historyLookup.end()) {
         item->index = -it->second - 1;
     }
@@ -68,11 +67,12 @@ bool HistoryManager::writeHistory(Item *selected) {
         return false;
     }
 
-    if (m_historyLookup.contains(selected->text)) {
-        m_historyLookup[selected->text] = m_historyLookup.size() - 1;
+    std::string text(selected->text, selected->length);
+    if (m_historyLookup.contains(text)) {
+        m_historyLookup[text] = m_historyLookup.size() - 1;
     }
     else {
-        m_historyLookup[selected->text] = m_historyLookup.size();
+        m_historyLookup[text] = m_historyLookup.size();
     }
 
     int size = m_historyLookup.size();
@@ -2,28 +2,44 @@
 
 ItemCache::ItemCache(ItemSorter *sorter) {
     m_sorter = sorter;
+    m_snapshot = m_sorter->snapshot();
     m_cache.setDatasource([this] (Item *buffer, int idx, int n) {
-        return m_sorter->copyItems(buffer, idx, n);
+        return m_sorter->copyItems(*m_snapshot, buffer, idx, n);
     });
 }
 
+// everything is read from the snapshot taken here until the next refresh,
+// so the sorter can publish new results at any time
 void ItemCache::refresh() {
-    m_cachedSize = m_sorter->size();
+    m_snapshot = m_sorter->snapshot();
     m_cache.refresh();
 }
 
+// reads the items around i from the same snapshot again, which replaces
+// placeholders with the items the sorter has sorted since
+void ItemCache::reload(int i) {
+    m_cache.refresh(i);
+}
+
 Item* ItemCache::get(int i) {
     return m_cache.get(i);
 }
 
+bool ItemCache::fetch(int i, Item *item) {
+    return m_sorter->fetchItem(i, item);
+}
+
 int ItemCache::size() {
-    return m_cachedSize;
+    return m_snapshot->size;
 }
 
 int ItemCache::getReserve() {
     return m_cache.getReserve();
 }
 
+// the sorter keeps enough items ready for the first window of the cache,
+// and for the half window it slides in after that
 void ItemCache::setReserve(int n) {
     m_cache.setReserve(n);
+    m_sorter->setFirstPageSize(n + n / 2);
 }
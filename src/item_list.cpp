@@ -29,7 +29,8 @@ void ItemList::drawItems() {
 }
 
 void ItemList::drawName(int i) {
-    std::string name = std::string(m_itemCache->get(i)->text);
+    Item *item = m_itemCache->get(i);
+    std::string name = std::string(item->text, item->length);
 
     if (name.size() > m_itemWidth) {
         name = name.substr(0, m_itemWidth - 1) + "…";
@@ -60,8 +61,8 @@ void ItemList::drawName(int i) {
 }
 
 void ItemList::drawHint(int i) {
-    char *text = m_itemCache->get(i)->text;
-    std::string hint = std::string(text + strlen(text) + 1);
+    Item *item = m_itemCache->get(i);
+    std::string hint = std::string(item->hint(), item->hintLength);
 
     m_styleManager->set(i == m_cursor ? m_config.activeHintStyle
             : m_config.hintStyle);
@@ -245,7 +246,6 @@ void ItemList::resize(int w, int h) {
             m_offset = m_cursor - m_nVisibleItems + 1;
         }
 
-        exit(1);
         drawItems();
     }
 }
@@ -305,9 +305,20 @@ void ItemList::refresh() {
     }
 }
 
+// unlike refresh, the cursor and offset stay where they are
+void ItemList::reload() {
+    m_itemCache->reload(m_offset);
+    calcVisibleItems();
+    drawItems();
+}
+
 Item* ItemList::getSelected() {
-    if (m_nVisibleItems) {
-        return m_itemCache->get(m_cursor);
+    if (!m_nVisibleItems) {
+        return nullptr;
+    }
+    Item *item = m_itemCache->get(m_cursor);
+    if (item && isPlaceholder(*item) && !m_itemCache->fetch(m_cursor, item)) {
+        return nullptr;
     }
-    return nullptr;
+    return item;
 }
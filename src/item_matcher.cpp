@@ -1,6 +1,9 @@
 #include "../include/item_matcher.hpp"
 #include "../include/item.hpp"
+#include "../include/simd.hpp"
 #include <climits>
+#include <cstdint>
+#include <algorithm>
 
 #define isupper(c) (c >= 'A' && c <= 'Z')
 #define islower(c) (c >= 'a' && c <= 'z')
@@ -14,77 +17,227 @@ const int NEW_WORD_BONUS = 101;
 const int CONSECUTIVE_BONUS = 200;
 const int DISTANCE_PENALTY = -50;
 
-inline int boundaryScore(const char *c) {
+const int64_t NO_SCORE = INT64_MIN / 2;
+
+// scratch space for score, reused between items so that scoring does not
+// allocate. rows are indexed by text position
+struct ScoreRows {
+    std::vector<int> boundary;  // boundaryScore of each character
+    std::vector<int> distance;  // number of boundaries up to and including
+    std::vector<int> first;     // leftmost possible position of each char
+    std::vector<int> last;      // rightmost possible position of each char
+    std::vector<int64_t> best[2];
+    std::vector<int64_t> consec[2];
+    std::vector<int> scores;    // word scores when none are passed to calc
+};
+
+static thread_local ScoreRows rows;
+
+// text is not null terminated, so the characters around c are only looked
+// at when they are within [begin, end)
+inline int boundaryScore(const char *c, const char *begin, const char *end) {
+    char prev = c > begin ? *(c - 1) : 0;
+    char next = c + 1 < end ? *(c + 1) : 0;
     if (islower(*c)) {
-        if (!isalpha(*(c - 1))) {
+        if (!isalpha(prev)) {
             return NEW_WORD_BONUS;
         }
     }
     else if (isupper(*c)) {
-        if (!isalpha(*(c - 1))) {
+        if (!isalpha(prev)) {
             return NEW_WORD_BONUS;
         }
-        if (!isupper(*(c - 1)) || islower(*(c + 1))) {
+        if (!isupper(prev) || islower(next)) {
             return BOUNDARY_BONUS;
         }
     }
-    else if ((isdigit(*c)) && !isdigit(*(c - 1))) {
+    else if ((isdigit(*c)) && !isdigit(prev)) {
         return BOUNDARY_BONUS;
     }
     return 0;
 }
 
-int ItemMatcher::calc(const char *text, std::vector<std::string>& queries) {
+ItemMatcher::ItemMatcher(const CompiledQuery& query) : m_query(query) {
+}
+
+int ItemMatcher::calc(const char *text, int length, uint64_t mask) {
+    rows.scores.assign(m_query.words().size(), UNKNOWN_SCORE);
+    return calc(text, length, mask, rows.scores.data());
+}
+
+int ItemMatcher::calc(const char *text, int length, uint64_t mask,
+                      int *scores)
+{
+    if ((mask & m_query.mask()) != m_query.mask()) {
+        return BAD_HEURISTIC;
+    }
+    switch (m_query.kind()) {
+        case QUERY_EMPTY:
+            return 0;
+        case QUERY_SINGLE_CHAR:
+            // the mask only rules items out: letters and digits have a bit
+            // each, but other bytes share theirs, so scoreChar still looks
+            // for the character and returns BAD_HEURISTIC if it's not there
+            return scoreChar(text, length, m_query.words()[0].text[0]);
+        default:
+            break;
+    }
+
+    // only items that contain every word are worth scoring
+    const std::vector<QueryWord>& words = m_query.words();
+    bool known = true;
+    for (size_t i = 0; i < words.size(); i++) {
+        if (scores[i] == BAD_HEURISTIC) {
+            return BAD_HEURISTIC;
+        }
+        if (scores[i] != UNKNOWN_SCORE) {
+            continue;
+        }
+        if (!isSubsequence(text, text + length, words[i].text.c_str())) {
+            scores[i] = BAD_HEURISTIC;
+            return BAD_HEURISTIC;
+        }
+        known = false;
+    }
+
+    if (!known) {
+        if ((int)rows.boundary.size() < length) {
+            rows.boundary.resize(length);
+            rows.distance.resize(length);
+            for (int i = 0; i < 2; i++) {
+                rows.best[i].resize(length);
+                rows.consec[i].resize(length);
+            }
+        }
+        int distance = 0;
+        for (int i = 0; i < length; i++) {
+            rows.boundary[i] = boundaryScore(text + i, text, text + length);
+            distance += rows.boundary[i] > 0;
+            rows.distance[i] = distance;
+        }
+    }
+
     int total = 0;
-    for (std::string& query : queries) {
-        int score = matchStart(text, query.c_str());
-        if (score == BAD_HEURISTIC) return BAD_HEURISTIC;
-        total += score;
+    for (size_t i = 0; i < words.size(); i++) {
+        if (scores[i] == UNKNOWN_SCORE) {
+            scores[i] = score(text, length, words[i]);
+        }
+        if (scores[i] == BAD_HEURISTIC) return BAD_HEURISTIC;
+        total += scores[i];
     }
     return total;
 }
 
-int ItemMatcher::matchStart(const char *tp, const char *qp) {
+// a single character scores like the first character of a longer word, with
+// nothing after it, so only the positions of c are looked at
+int ItemMatcher::scoreChar(const char *text, int length, char c) {
     int maxScore = BAD_HEURISTIC;
-    int first = BOUNDARY_BONUS;
-    int depth = 0;
-    while (*tp) {
-        if (tolower(*tp) == *qp) {
-            int boundary = boundaryScore(tp);
-            int score = 0;
-            if (*(qp + 1)) {
-                score = match(tp + 1, qp + 1, 1, boundary > 0, &depth);
-                if (score == BAD_HEURISTIC) return maxScore;
-            }
-            score += MATCH_BONUS + std::max(boundary, first);
-            maxScore = std::max(score, maxScore);
+    for (int p = 0; p < length; p++) {
+        if (tolower(text[p]) != c) {
+            continue;
         }
-        tp++;
-        first = 0;
+        int bonus = boundaryScore(text + p, text, text + length);
+        bonus = std::max(bonus, p == 0 ? BOUNDARY_BONUS : 0);
+        maxScore = std::max(maxScore, MATCH_BONUS + bonus);
     }
     return maxScore;
 }
 
-int ItemMatcher::match(const char *tp, const char *qp, int dist, bool consec,
-                       int *depth)
+// finds the best scoring way to match a word in text
+//
+// a match is a list of positions p[0] < ... < p[m-1], one for each query
+// character. the first character scores MATCH_BONUS plus its boundary bonus
+// (at least BOUNDARY_BONUS at the start of the text). every other character
+// scores MATCH_BONUS, plus 1 on a boundary, plus CONSECUTIVE_BONUS if it
+// directly follows the previous character and the run it continues touches
+// a boundary, plus DISTANCE_PENALTY for each boundary since p[0] (and one
+// more). the distance part only depends on p[0] and p[k], so it can be split
+// between the first character and the rest, which makes every character's
+// score depend only on its own position and the one before it
+//
+// row k holds the best score of matching query[0..k] with query[k] at each
+// position. best is over all matches, consec only over matches where the run
+// ending at that position touches a boundary. a row only covers the
+// positions between the leftmost and rightmost places query[k] can go, so
+// the cost is O(length * m) at worst, and usually far less
+int ItemMatcher::score(const char *text, int length, const QueryWord& word)
 {
-    int maxScore = BAD_HEURISTIC;
-    while (*tp) {
-        bool boundary = boundaryScore(tp);
-        dist += boundary > 0;
-        if (tolower(*tp) == *qp) {
-            int score = 0;
-            if (*(qp + 1)) {
-                score = match(tp + 1, qp + 1, dist, consec || boundary, depth);
-                if (score == BAD_HEURISTIC) return maxScore;
+    const char *query = word.text.c_str();
+    const int m = word.length;
+    if ((int)rows.first.size() < m) {
+        rows.first.resize(m);
+        rows.last.resize(m);
+    }
+
+    // bounds for each query character, from a greedy match in each direction
+    for (int k = 0, p = 0; k < m; k++, p++) {
+        while (p < length && tolower(text[p]) != query[k]) p++;
+        if (p == length) return BAD_HEURISTIC;
+        rows.first[k] = p;
+    }
+    for (int k = m - 1, p = length - 1; k >= 0; k--, p--) {
+        while (tolower(text[p]) != query[k]) p--;
+        rows.last[k] = p;
+    }
+
+    const int *boundary = rows.boundary.data();
+    const int *distance = rows.distance.data();
+
+    int64_t *best = rows.best[0].data();
+    int64_t *consec = rows.consec[0].data();
+    for (int p = rows.first[0]; p <= rows.last[0]; p++) {
+        if (tolower(text[p]) != query[0]) {
+            best[p] = consec[p] = NO_SCORE;
+            continue;
+        }
+        int bonus = std::max(boundary[p], p == 0 ? BOUNDARY_BONUS : 0);
+        best[p] = MATCH_BONUS + bonus
+            - (int64_t)DISTANCE_PENALTY * (m - 1) * distance[p];
+        consec[p] = boundary[p] > 0 ? best[p] : NO_SCORE;
+    }
+
+    for (int k = 1; k < m; k++) {
+        const int64_t *prevBest = best;
+        const int64_t *prevConsec = consec;
+        best = rows.best[k & 1].data();
+        consec = rows.consec[k & 1].data();
+
+        int prevFirst = rows.first[k - 1];
+        int prevLast = rows.last[k - 1];
+        int64_t before = NO_SCORE;
+        int j = prevFirst;
+
+        for (int p = rows.first[k]; p <= rows.last[k]; p++) {
+            // best score with query[k - 1] anywhere before p
+            for (; j < p && j <= prevLast; j++) {
+                before = std::max(before, prevBest[j]);
+            }
+            if (tolower(text[p]) != query[k]) {
+                best[p] = consec[p] = NO_SCORE;
+                continue;
+            }
+
+            bool isBoundary = boundary[p] > 0;
+            int64_t s = MATCH_BONUS + isBoundary
+                + (int64_t)DISTANCE_PENALTY * (1 + distance[p]);
+            int64_t apart = before == NO_SCORE ? NO_SCORE : before + s;
+            int64_t joined = NO_SCORE;
+            if (p - 1 >= prevFirst && p - 1 <= prevLast
+                    && prevConsec[p - 1] != NO_SCORE) {
+                joined = prevConsec[p - 1] + s + CONSECUTIVE_BONUS;
             }
-            score += MATCH_BONUS + boundary + consec * CONSECUTIVE_BONUS
-                + dist * DISTANCE_PENALTY;
-            maxScore = std::max(score, maxScore);
-            if (++(*depth) > 100) return maxScore;
+
+            best[p] = std::max(apart, joined);
+            consec[p] = isBoundary ? best[p] : joined;
         }
-        tp++;
-        consec = false;
     }
-    return maxScore;
+
+    int64_t maxScore = NO_SCORE;
+    for (int p = rows.first[m - 1]; p <= rows.last[m - 1]; p++) {
+        maxScore = std::max(maxScore, best[p]);
+    }
+    if (maxScore == NO_SCORE) {
+        return BAD_HEURISTIC;
+    }
+    return std::clamp<int64_t>(maxScore, BAD_HEURISTIC + 1, INT_MAX);
 }
@@ -1,8 +1,14 @@
 #include "../include/item_reader.hpp"
+#include "../include/simd.hpp"
+#include "../include/thread_pool.hpp"
 #include <cstring>
 #include <cstdlib>
+#include <cerrno>
 #include <chrono>
 #include <thread>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
 
 using namespace std::chrono_literals;
 using std::chrono::time_point;
@@ -11,8 +17,23 @@ using std::chrono::system_clock;
 
 #define INTERVAL 50ms
 
-ItemReader::ItemReader(FILE *file) {
-    m_file = file;
+// a read is only issued once this much space is free in the arena block
+const size_t MIN_READ_SIZE = 64 << 10;
+
+// upper bound for a single read, so items keep getting dispatched while a
+// large file is being read
+const size_t MAX_READ_SIZE = 1 << 20;
+
+// mapped files are split into windows of about this size. each window is
+// divided into up to RANGES_PER_THREAD ranges for each thread, with every
+// range getting at least MIN_RANGE_SIZE bytes
+const size_t MAPPED_WINDOW_SIZE = 32 << 20;
+const size_t MIN_RANGE_SIZE = 256 << 10;
+const size_t RANGES_PER_THREAD = 4;
+
+ItemReader::ItemReader(int fileDescriptor, ItemChunkQueue *queue) {
+    m_fileDescriptor = fileDescriptor;
+    m_queue = queue;
     m_readHints = false;
     m_itemId = 0;
 
@@ -24,69 +45,311 @@ void ItemReader::setReadHints(bool readHints) {
     m_readHints = readHints;
 }
 
+bool ItemReader::addInputFile(const std::string& path) {
+    MappedFile *file = new MappedFile();
+    if (!file->open(path)) {
+        delete file;
+        return false;
+    }
+    m_inputFiles.push_back(file);
+    return true;
+}
+
+void ItemReader::readSizeHint() {
+    // the size of a regular file is known up front, so the rest of it can be
+    // read into a single arena block. the extra byte leaves room to read the
+    // end of the file
+    struct stat st;
+    if (!fstat(m_fileDescriptor, &st) && S_ISREG(st.st_mode)) {
+        off_t pos = lseek(m_fileDescriptor, 0, SEEK_CUR);
+        if (pos >= 0 && st.st_size >= pos) {
+            m_hasSizeHint = true;
+            m_sizeHint = st.st_size - pos;
+            m_arena.reserve(m_sizeHint + 1, 0);
+        }
+    }
+}
+
 bool ItemReader::read() {
-    if (m_readHints) {
-        return readWithHints();
+    if (m_inputFiles.size()) {
+        return readMapped();
     }
-    return readWithoutHints();
+    return readStream();
 }
 
-bool ItemReader::readWithHints() {
-    size_t size;
-    char *buf = nullptr;
-    char *secondBuf = nullptr;
+bool ItemReader::readStream() {
+    size_t want = MIN_READ_SIZE;
+    if (m_hasSizeHint) {
+        want = std::clamp(m_sizeHint, (size_t)1, MIN_READ_SIZE);
+    }
+    m_arena.reserve(m_pending + want, m_pending);
 
-    if (getline(&buf, &size, m_file) < 0) {
+    char *buf = m_arena.tail();
+    size_t count = std::min(m_arena.available() - m_pending, MAX_READ_SIZE);
+
+    ssize_t n = ::read(m_fileDescriptor, buf + m_pending, count);
+    if (n < 0 && errno == EINTR) {
+        return true;
+    }
+    if (n <= 0) {
+        // the input may not end with a newline, in which case the last
+        // line is still sitting at the arena's tail
+        if (m_pending) {
+            splitLines(buf, m_pending, true);
+            m_arena.commit(m_pending);
+            m_pending = 0;
+        }
         return false;
     }
 
-    if (getline(&secondBuf, &size, m_file) < 0) {
-        return false;
+    if (m_hasSizeHint) {
+        m_sizeHint = (size_t)n < m_sizeHint ? m_sizeHint - n : 0;
     }
 
-    buf[strcspn(buf, "\n")] = 0;
-    secondBuf[strcspn(secondBuf, "\n")] = 0;
+    m_pending += n;
+    size_t used = splitLines(buf, m_pending, false);
+    m_arena.commit(used);
+    m_pending -= used;
 
-    char *thirdBuf = (char*)malloc(strlen(buf) + strlen(secondBuf) + 2);
+    return true;
+}
 
-    strcpy(thirdBuf, buf);
-    strcpy(thirdBuf + strlen(buf) + 1, secondBuf);
+bool ItemReader::readMapped() {
+    while (m_fileIdx < m_inputFiles.size()) {
+        MappedFile *file = m_inputFiles[m_fileIdx];
+        const char *buf = file->data() + m_fileOffset;
+        size_t size = file->size() - m_fileOffset;
+
+        if (size) {
+            m_fileOffset += splitMapped(buf, size);
+            if (m_fileOffset < file->size()) {
+                return true;
+            }
+        }
 
-    free(secondBuf);
-    free(buf);
+        m_fileIdx++;
+        m_fileOffset = 0;
+    }
+    return false;
+}
+
+// the items point straight into the mapping. only a window of the file is
+// split per call, so items keep getting dispatched. the window is divided
+// into ranges which are split on separate threads: the lines in each range
+// are counted first, which gives every range the position of its first item,
+// and then each range writes its items directly into place
+size_t ItemReader::splitMapped(const char *buf, size_t size) {
+    // the window ends on a line boundary
+    const char *end = buf + size;
+    if (size > MAPPED_WINDOW_SIZE) {
+        const char *newline = findNewline(buf + MAPPED_WINDOW_SIZE, end);
+        if (newline) {
+            end = newline + 1;
+        }
+    }
+    size_t windowSize = end - buf;
+
+    // there are a few ranges per thread, so that threads which finish early
+    // can take over ranges of the others
+    ThreadPool& pool = ThreadPool::instance();
+    int nRanges = std::clamp(windowSize / MIN_RANGE_SIZE, (size_t)1,
+            (size_t)pool.numThreads() * RANGES_PER_THREAD);
+    std::vector<LineRange> ranges;
+    const char *start = buf;
+    for (int i = 1; i <= nRanges && start < end; i++) {
+        const char *rangeEnd = end;
+        if (i < nRanges) {
+            // every range starts at the beginning of a line
+            rangeEnd = buf + windowSize / nRanges * i;
+            const char *newline = findNewline(std::max(rangeEnd - 1, start),
+                    end);
+            rangeEnd = newline ? newline + 1 : end;
+        }
+        ranges.push_back({start, rangeEnd, 0, 0});
+        start = rangeEnd;
+    }
 
-    Item item;
-    item.text = thirdBuf;
-    item.index = m_itemId++;
-    item.heuristic = 0;
-    m_itemsBuf.getPrimary().push_back(item);
+    pool.run(ranges.size(), 1, [&] (int, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            ranges[i].lines = countNewlines(ranges[i].begin, ranges[i].end);
+        }
+    });
 
-    return true;
+    // the last line of the file may not end with a newline
+    if (end == buf + size && end[-1] != '\n') {
+        ranges.back().lines++;
+    }
+
+    int lines = 0;
+    for (LineRange& range : ranges) {
+        range.firstLine = lines;
+        lines += range.lines;
+    }
+
+    // with hints, a window has to end after a hint line
+    if (m_readHints && lines % 2 && end < buf + size) {
+        const char *newline = findNewline(end, buf + size);
+        end = newline ? newline + 1 : buf + size;
+        ranges.back().end = end;
+        ranges.back().lines++;
+        lines++;
+    }
+
+    // the items continue the current chunk, and fill as many new chunks as
+    // they need
+    int nItems = m_readHints ? lines / 2 : lines;
+    if (!m_chunk) {
+        m_chunk = new ItemChunk;
+    }
+    int base = m_chunk->size;
+    std::vector<ItemChunk*> chunks = {m_chunk};
+    for (int n = base + nItems; n > ITEM_CHUNK_SIZE; n -= ITEM_CHUNK_SIZE) {
+        chunks.back()->size = ITEM_CHUNK_SIZE;
+        chunks.push_back(new ItemChunk);
+    }
+    chunks.back()->size = (base + nItems - 1) % ITEM_CHUNK_SIZE + 1;
+
+    pool.run(ranges.size(), 1, [&] (int, size_t begin, size_t stop) {
+        for (size_t i = begin; i < stop; i++) {
+            splitRange(&ranges[i], end, chunks.data(), base);
+        }
+    });
+
+    m_itemId += nItems;
+    m_chunk = chunks.back();
+    chunks.pop_back();
+    for (ItemChunk *chunk : chunks) {
+        m_pendingChunks.push_back(chunk);
+    }
+    if (m_chunk->size == ITEM_CHUNK_SIZE) {
+        m_pendingChunks.push_back(m_chunk);
+        m_chunk = nullptr;
+    }
+    pushChunks();
+
+    return end - buf;
 }
 
-bool ItemReader::readWithoutHints() {
-    size_t size;
-    char *buf = nullptr;
+// writes the items of a range to their place in chunks, where the first
+// item goes to position base of the first chunk. a text line always starts
+// inside its range, but its hint may be in the next range
+void ItemReader::splitRange(LineRange *range, const char *end,
+        ItemChunk **chunks, int base)
+{
+    const char *start = range->begin;
+    int line = range->firstLine;
+
+    // the range starts with a hint which belongs to the previous range
+    if (m_readHints && line % 2) {
+        const char *newline = findNewline(start, range->end);
+        start = newline ? newline + 1 : range->end;
+        line++;
+    }
+
+    int idx = m_readHints ? line / 2 : line;
+    while (start < range->end) {
+        const char *newline = findNewline(start, end);
+        if (!newline) {
+            newline = end;
+        }
 
-    if (getline(&buf, &size, m_file) < 0) {
-        return false;
+        const char *next = newline + 1;
+        int hintLength = 0;
+        if (m_readHints) {
+            // an item without a hint line is dropped at the end
+            if (next >= end) {
+                break;
+            }
+            const char *hintNewline = findNewline(next, end);
+            if (!hintNewline) {
+                hintNewline = end;
+            }
+            hintLength = hintNewline - next;
+            next = hintNewline + 1;
+        }
+
+        int slot = base + idx;
+        chunks[slot / ITEM_CHUNK_SIZE]->set(slot % ITEM_CHUNK_SIZE, start,
+                newline - start, hintLength, m_itemId + idx);
+        idx++;
+        start = next;
     }
+}
+
+// turns every complete line (or pair of lines when reading hints) in buf
+// into an item, and returns the number of bytes used. when isEnd is set, a
+// last line without a newline is used as well
+size_t ItemReader::splitLines(const char *buf, size_t size, bool isEnd) {
+    const char *start = buf;
+    const char *end = buf + size;
+
+    while (start < end) {
+        const char *newline = findNewline(start, end);
+        if (!newline) {
+            if (!isEnd) {
+                break;
+            }
+            newline = end;
+        }
+
+        const char *next = newline + 1;
+        int hintLength = 0;
+        if (m_readHints) {
+            // the hint is the line directly after the text
+            if (next >= end) {
+                // an item without a hint line is dropped at the end
+                if (isEnd) {
+                    start = end;
+                }
+                break;
+            }
+            const char *hintNewline = findNewline(next, end);
+            if (!hintNewline) {
+                if (!isEnd) {
+                    break;
+                }
+                hintNewline = end;
+            }
+            hintLength = hintNewline - next;
+            next = hintNewline + 1;
+        }
 
-    buf[strcspn(buf, "\n")] = 0;
+        addItem(start, newline - start, hintLength);
+        start = next;
+    }
 
-    Item item;
-    item.text = buf;
-    item.index = m_itemId++;
-    m_itemsBuf.getPrimary().push_back(item);
+    return std::min(start, end) - buf;
+}
 
-    buf = nullptr;
+void ItemReader::addItem(const char *text, int length, int hintLength) {
+    if (!m_chunk) {
+        m_chunk = new ItemChunk;
+    }
+    m_chunk->set(m_chunk->size++, text, length, hintLength, m_itemId++);
+    if (m_chunk->size == ITEM_CHUNK_SIZE) {
+        m_pendingChunks.push_back(m_chunk);
+        m_chunk = nullptr;
+        pushChunks();
+    }
+}
 
+// moves finished chunks into the queue. returns false if the queue is full,
+// in which case the sorter is woken up to make room
+bool ItemReader::pushChunks() {
+    while (m_pendingChunks.size()) {
+        if (!m_queue->push(m_pendingChunks.front())) {
+            dispatchItems();
+            return false;
+        }
+        m_pendingChunks.pop_front();
+        m_hasPushedChunks = true;
+    }
     return true;
 }
 
 void ItemReader::readFirstBatch() {
     time_point start = system_clock::now();
-    for (int i = 0; i < 128; i++) {
+    while (m_itemId < 128) {
 
         bool success = read();
         if (!success) {
@@ -120,21 +383,30 @@ void ItemReader::onEvent(std::shared_ptr<Event> event) {
             break;
         }
         case ITEMS_ADDED_EVENT:
-            m_itemsRead = true;
+            // the sorter made room in the queue, which onLoop checks
             break;
         default:
             break;
     }
 }
 
+// lets the sorter know there are chunks waiting in the queue
 void ItemReader::dispatchItems() {
-    if (!m_itemsBuf.getPrimary().size()) {
+    if (!m_hasPushedChunks) {
         return;
     }
-    m_itemsRead = false;
-    m_itemsBuf.swap();
-    m_dispatch.dispatch(std::make_shared<NewItemsEvent>(&m_itemsBuf.getSecondary()));
-    m_itemsBuf.getPrimary().clear();
+    m_hasPushedChunks = false;
+    m_dispatch.dispatch(std::make_shared<NewItemsEvent>());
+}
+
+// hands over the partly filled chunk, so slow inputs still show up
+void ItemReader::flushItems() {
+    if (m_chunk && m_chunk->size) {
+        m_pendingChunks.push_back(m_chunk);
+        m_chunk = nullptr;
+    }
+    pushChunks();
+    dispatchItems();
 }
 
 void ItemReader::intervalThread() {
@@ -147,10 +419,23 @@ void ItemReader::intervalThread() {
 }
 
 void ItemReader::onStart() {
-    m_itemsRead = true;
+    // a regular file on stdin is mapped just like the --input files. the
+    // stream reader is only used for pipes, or if mapping fails
+    if (m_inputFiles.empty()) {
+        MappedFile *file = new MappedFile();
+        off_t pos = lseek(m_fileDescriptor, 0, SEEK_CUR);
+        if (pos >= 0 && file->open(m_fileDescriptor) && (size_t)pos <= file->size()) {
+            m_inputFiles.push_back(file);
+            m_fileOffset = pos;
+        }
+        else {
+            delete file;
+            readSizeHint();
+        }
+    }
 
     readFirstBatch();
-    dispatchItems();
+    flushItems();
 
     m_intervalActive = true;
     m_intervalThread = new std::thread(
@@ -158,17 +443,27 @@ void ItemReader::onStart() {
 }
 
 void ItemReader::onLoop() {
-    if (m_itemsRead && m_intervalPassed) {
+    if (m_intervalPassed) {
         m_intervalPassed = false;
-        dispatchItems();
+        flushItems();
+    }
+
+    // the queue is full, so nothing more is read until the sorter has
+    // taken some chunks
+    if (!pushChunks()) {
+        awaitEvent();
+        return;
     }
+
     if (!read()) {
-        if (m_itemsRead || !m_itemsBuf.getPrimary().size()) {
-            dispatchItems();
+        flushItems();
+        if (m_pendingChunks.empty()) {
             m_dispatch.dispatch(std::make_shared<AllItemsReadEvent>());
             endInterval();
             end();
         }
-        awaitEvent();
+        else {
+            awaitEvent();
+        }
     }
 }
@@ -1,57 +1,185 @@
 #include "../include/item_sorter.hpp"
 #include "../include/util.hpp"
 #include "../include/item_matcher.hpp"
-#include "../include/thread_manager.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/top_k.hpp"
+#include "../include/radix_sort.hpp"
 #include <unordered_map>
 #include <cstring>
 #include <climits>
 
 using namespace std::chrono_literals;
 
-ItemSorter::ItemSorter() {
+ItemSorter::ItemSorter(ItemChunkQueue *queue) {
+    m_queue = queue;
     m_isSorted = false;
     m_queryChanged = false;
-    m_heuristicIdx = 0;
+    m_heuristicChunks = 0;
     m_sortIdx = 0;
+    m_snapshot = std::make_shared<const ItemSnapshot>();
 
     m_dispatch.subscribe(this, QUERY_CHANGE_EVENT);
     m_dispatch.subscribe(this, NEW_ITEMS_EVENT);
     m_dispatch.subscribe(this, QUIT_EVENT);
 }
 
-bool sortFunc(Item& l, Item& r) {
-    if (l.heuristic == r.heuristic) {
-        if (strlen(l.text) == strlen(r.text)) {
-            return l.index < r.index;
-        }
-        return strlen(l.text) < strlen(r.text);
+bool ItemOrder::operator()(int l, int r) const {
+    ItemChunk *lc = store->getChunk(l);
+    ItemChunk *rc = store->getChunk(r);
+    l = ItemStore::getOffset(l);
+    r = ItemStore::getOffset(r);
+    if (isSorted && lc->heuristic[l] != rc->heuristic[r]) {
+        return lc->heuristic[l] > rc->heuristic[r];
+    }
+    if (isSorted && lc->length[l] != rc->length[r]) {
+        return lc->length[l] < rc->length[r];
     }
-    return l.heuristic > r.heuristic;
+    return lc->index[l] < rc->index[r];
 }
 
-bool sortEmptyFunc(Item& l, Item& r) {
-    return l.index < r.index;
+ItemOrder ItemSorter::order() {
+    return {&m_store, m_isSorted};
 }
 
+// sorts m_order up to sortIdx. nth_element moves the items before sortIdx
+// in front of the rest in linear time, so only those need a full sort. the
+// sorted part at least doubles each time, and once half of what is left
+// would be sorted, all of it is
 void ItemSorter::sort(int sortIdx) {
-    if (sortIdx <= m_sortIdx) {
+    int size = m_order.size();
+    if (sortIdx <= m_sortIdx || m_sortIdx >= size) {
         return;
     }
-    if (sortIdx > m_items.size()) {
-        sortIdx = m_items.size();
-    }
-    std::function<bool(Item& l, Item &r)> f;
-    f = m_isSorted ? sortFunc : sortEmptyFunc;
 
+    sortIdx = std::min(std::max(sortIdx, m_sortIdx * 2), size);
     m_logger.log("sorting from %d to %d", m_sortIdx, sortIdx);
-
-    std::partial_sort(m_items.begin() + m_sortIdx,
-            m_items.begin() + sortIdx, m_items.end(), f);
+    if (sortIdx - m_sortIdx >= (size - m_sortIdx) / 2) {
+        sortFrom(m_sortIdx);
+        m_sortIdx = size;
+        return;
+    }
+    std::nth_element(m_order.begin() + m_sortIdx, m_order.begin() + sortIdx,
+            m_order.end(), order());
+    std::sort(m_order.begin() + m_sortIdx, m_order.begin() + sortIdx,
+            order());
     m_sortIdx = sortIdx;
 }
 
-int ItemSorter::size() {
-    return m_items.size();
+// sorts m_order from begin to the end, without looking at what comes before
+void ItemSorter::sortFrom(int begin) {
+    if (m_order.size() - begin < RADIX_SORT_THRESHOLD
+            || !radixSortOrder(begin)) {
+        std::sort(m_order.begin() + begin, m_order.end(), order());
+    }
+}
+
+static int bitWidth(uint64_t range) {
+    return range ? 64 - __builtin_clzll(range) : 0;
+}
+
+// packs the heuristic, length and index of every item from begin on into a
+// single key which orders the same way as ItemOrder, and radix sorts by it.
+// each field only takes as many bits as its range of values needs. returns
+// false if the fields don't fit into 64 bits
+bool ItemSorter::radixSortOrder(int begin) {
+    int *ids = m_order.data() + begin;
+    size_t n = m_order.size() - begin;
+
+    int64_t minHeuristic = INT_MAX, maxHeuristic = INT_MIN;
+    int64_t minLength = INT_MAX, maxLength = INT_MIN;
+    int64_t minIndex = INT_MAX, maxIndex = INT_MIN;
+    for (size_t i = 0; i < n; i++) {
+        ItemChunk *c = m_store.getChunk(ids[i]);
+        int j = ItemStore::getOffset(ids[i]);
+        minHeuristic = std::min<int64_t>(minHeuristic, c->heuristic[j]);
+        maxHeuristic = std::max<int64_t>(maxHeuristic, c->heuristic[j]);
+        minLength = std::min<int64_t>(minLength, c->length[j]);
+        maxLength = std::max<int64_t>(maxLength, c->length[j]);
+        minIndex = std::min<int64_t>(minIndex, c->index[j]);
+        maxIndex = std::max<int64_t>(maxIndex, c->index[j]);
+    }
+    if (!m_isSorted) {
+        maxHeuristic = minHeuristic;
+        maxLength = minLength;
+    }
+
+    int indexBits = bitWidth(maxIndex - minIndex);
+    int lengthBits = bitWidth(maxLength - minLength);
+    int heuristicBits = bitWidth(maxHeuristic - minHeuristic);
+    int bits = indexBits + lengthBits + heuristicBits;
+    if (bits > 64) {
+        return false;
+    }
+
+    // higher heuristics come first, so they get lower keys
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        ItemChunk *c = m_store.getChunk(ids[i]);
+        int j = ItemStore::getOffset(ids[i]);
+        uint64_t key = m_isSorted ? maxHeuristic - c->heuristic[j] : 0;
+        key = (key << lengthBits)
+            | (m_isSorted ? c->length[j] - minLength : 0);
+        keys[i] = (key << indexBits) | (c->index[j] - minIndex);
+    }
+
+    radixSort(keys.data(), ids, n, bits);
+    return true;
+}
+
+// moves the best of m_topCandidates to the front of m_order, in order
+// the workers only hand in the best m_firstPageSize items they scored, so
+// this never has to look at the scores of the other matches
+// if items were only appended from tail on, the best items are either in
+// the first page of the sorted prefix or in the new items, so a batch only
+// costs about its own size, and the rest of m_order is left for sort to
+// order when the ui scrolls down to it
+void ItemSorter::placeTopItems(int tail) {
+    std::vector<int>& top = m_topCandidates;
+    int n = std::min((int)top.size(), m_firstPageSize);
+    std::partial_sort(top.begin(), top.begin() + n, top.end(), order());
+    top.resize(n);
+
+    std::vector<int> ids = top;
+    std::sort(ids.begin(), ids.end());
+    auto isTop = [&] (int id) {
+        return std::binary_search(ids.begin(), ids.end(), id);
+    };
+    int sorted = std::min(m_sortIdx, m_firstPageSize);
+    if (tail == 0 || n > sorted) {
+        std::partition(m_order.begin(), m_order.end(), isTop);
+    }
+    else {
+        // new items which made it to the top trade places with the items
+        // which dropped out of the first page
+        auto dropped = std::partition(m_order.begin(),
+                m_order.begin() + sorted, isTop);
+        auto added = std::partition(m_order.begin() + tail, m_order.end(),
+                isTop);
+        std::swap_ranges(m_order.begin() + tail, added, dropped);
+    }
+    std::copy(top.begin(), top.end(), m_order.begin());
+    m_sortIdx = n;
+}
+
+
+void ItemSorter::setFirstPageSize(int n) {
+    n = std::max(n, FIRST_ITEMS_SIZE);
+    {
+        std::unique_lock lock(m_sorter_mut);
+        if (n == m_nextFirstPageSize) {
+            return;
+        }
+        m_nextFirstPageSize = n;
+    }
+    m_sorter_cv.notify_one();
+}
+
+std::shared_ptr<const ItemSnapshot> ItemSorter::snapshot() {
+    return m_snapshot.load();
+}
+
+void ItemSorter::setQueryCacheLimit(size_t bytes) {
+    m_queryCache.setLimit(bytes);
 }
 
 void ItemSorter::setQuery() {
@@ -59,111 +187,491 @@ void ItemSorter::setQuery() {
     if (m_query == m_newQuery) {
         return;
     }
-    bool shrunk = m_newQuery.size() < m_query.size();
-    bool backspaced = shrunk || (!shrunk && !m_newQuery.starts_with(m_query));
-
-    if (backspaced) {
-        m_heuristicIdx = 0;
+    // the empty query is cheaper to order again than to restore
+    if (m_heuristicsDone && !m_query.empty()) {
+        m_queryCache.put(m_query, m_heuristicChunks, m_sortIdx, m_store,
+                m_order);
+    }
+    m_heuristicsDone = false;
+
+    // narrowing from the current matches is only worth it if nothing closer
+    // to the new query is cached
+    bool extended = m_newQuery.starts_with(m_query);
+    const QueryCacheEntry *entry = m_queryCache.find(m_newQuery);
+    if (entry && (!extended || entry->query.size() > m_query.size())) {
+        m_logger.log("restoring %d matches of \"%s\"",
+                (int)entry->ids.size(), entry->query.c_str());
+        m_order = entry->ids;
+        for (size_t i = 0; i < m_order.size(); i++) {
+            int id = m_order[i];
+            m_store.getChunk(id)->heuristic[ItemStore::getOffset(id)]
+                = entry->heuristics[i];
+        }
+        m_heuristicChunks = entry->chunks;
+        m_narrow = entry->query != m_newQuery;
+        m_sortIdx = entry->sorted;
+    }
+    else if (extended) {
+        m_narrow = true;
+    }
+    else {
+        m_heuristicChunks = 0;
+        m_narrow = false;
     }
 
     m_query = m_newQuery;
+    m_compiledQuery = CompiledQuery(m_query, m_stats);
 }
 
-void ItemSorter::calcHeuristics(bool queryChanged) {
-    if (queryChanged && m_heuristicIdx) {
-        m_logger.log("fast calcHeuristics for %d items", m_heuristicIdx);
-        calcHeuristics(false, 0, m_heuristicIdx);
-    }
-    int n = m_items.size();
-    if (n && n > m_heuristicIdx) {
-        m_logger.log("slow calcHeuristics for %d items", n - m_heuristicIdx);
-        calcHeuristics(true, m_heuristicIdx, n);
-    }
-    m_heuristicIdx = n;
+bool ItemSorter::cancelled() const {
+    return m_epoch.load(std::memory_order_relaxed) != m_passEpoch;
 }
 
-void ItemSorter::calcHeuristics(bool newItems, int start, int end)
-{
-    std::function<void(Item*, int)> f;
-    ItemMatcher matcher;
-    std::vector<std::string> words = split(m_query, ' ');
+bool ItemSorter::calcHeuristics() {
+    m_isSorted = !m_compiledQuery.empty();
+    prepareWordScores();
+    if (!m_isSorted) {
+        orderByIndex();
+        return true;
+    }
+    bool scored = false;
+
+    // when the query is only extended, nothing outside m_order can start
+    // matching, so only the current candidates need to be looked at
+    bool narrow = m_narrow && m_heuristicChunks;
+    int n = m_store.numChunks();
+    ItemChunk **chunks = m_store.getChunks();
+    m_passScored = 0;
+    m_passSize = narrow ? m_order.size() : 0;
+    for (int i = m_heuristicChunks; i < n; i++) {
+        m_passSize += chunks[i]->size;
+    }
+    m_lastPublish = std::chrono::steady_clock::now();
+    if (narrow || m_heuristicChunks == 0) {
+        m_sortIdx = 0;
+    }
+    else if (m_sortIdx < std::min(m_firstPageSize, (int)m_order.size())) {
+        // the first page grew since m_order was sorted (eg. the terminal was
+        // resized during a pass), so the best of the old matches have to be
+        // picked out again
+        sort(m_firstPageSize);
+    }
 
-    m_isSorted = m_query.size() > 0;
+    // anything that is not scored again keeps its place, so the best items
+    // are the best of what was sorted before and of what gets scored
+    int sorted = std::min(m_sortIdx, m_firstPageSize);
+    m_topCandidates.assign(m_order.begin(), m_order.begin() + sorted);
 
-    if (m_isSorted) {
-        f = [&] (Item *item, int n) {
-            for (int i = 0; i < n; i++) {
-                if (m_queryChanged) {
-                    return;
-                }
-                if (!newItems && item->heuristic == BAD_HEURISTIC) {
-                    item++;
-                    continue;
+    if (narrow) {
+        m_logger.log("narrowing %d candidates", (int)m_order.size());
+        if (!calcCandidates()) {
+            return false;
+        }
+        scored = true;
+    }
+    m_narrow = false;
+
+    // without narrowing, the matches of new chunks are only appended
+    bool append = !narrow && m_heuristicChunks > 0;
+    int tail = m_order.size();
+    if (n > m_heuristicChunks) {
+        m_logger.log("calcHeuristics for %d chunks", n - m_heuristicChunks);
+        if (!calcChunks(m_heuristicChunks, n)) {
+            return false;
+        }
+        if (m_heuristicChunks == 0) {
+            m_order.clear();
+        }
+        for (int i = m_heuristicChunks; i < n; i++) {
+            for (int j = 0; j < chunks[i]->size; j++) {
+                if (chunks[i]->heuristic[j] != BAD_HEURISTIC) {
+                    m_order.push_back((i << ITEM_CHUNK_BITS) | j);
                 }
-                (*item).heuristic = matcher.calc((*item).text, words);
-                item++;
             }
-        };
+        }
+        m_heuristicChunks = n;
+        scored = true;
     }
-    else {
-        f = [] (Item *item, int n) {
-            for (int i = 0; i < n; i++) {
-                item->heuristic = 0;
-                item++;
+
+    if (scored) {
+        placeTopItems(append ? tail : 0);
+    }
+    m_heuristicsDone = true;
+    return true;
+}
+
+// without a query every item matches, and the reader hands out indexes in
+// the order items are added to the store, so there is nothing to score or
+// sort. only items with a negative index (eg. from the history) are kept in
+// a small sorted prefix
+void ItemSorter::orderByIndex() {
+    int n = m_store.numChunks();
+    ItemChunk **chunks = m_store.getChunks();
+    if (m_heuristicChunks == 0) {
+        m_order.clear();
+    }
+
+    std::vector<int> front;
+    for (int i = m_heuristicChunks; i < n; i++) {
+        for (int j = 0; j < chunks[i]->size; j++) {
+            int id = (i << ITEM_CHUNK_BITS) | j;
+            if (chunks[i]->index[j] < 0) {
+                front.push_back(id);
             }
-        };
+            else {
+                m_order.push_back(id);
+            }
+        }
+    }
+    if (!front.empty()) {
+        auto end = std::partition_point(m_order.begin(), m_order.end(),
+                [this] (int id) {
+            return m_store.getChunk(id)->index[ItemStore::getOffset(id)] < 0;
+        });
+        end = m_order.insert(end, front.begin(), front.end()) + front.size();
+        std::sort(m_order.begin(), end, order());
     }
 
-    ThreadManager<Item> manager(f);
-    manager.setNumThreads(4);
-    manager.setThreshold(1024);
-    manager.run(m_items.data() + start, end - start);
+    m_heuristicChunks = n;
+    m_narrow = false;
+    m_sortIdx = m_order.size();
+    m_heuristicsDone = true;
+}
 
-    m_sortIdx = 0;
+// the score of a word for an item never changes, so with several words in
+// the query, the score of each word is kept per item. editing one word then
+// only needs that word to be scored again. columns are only kept for the
+// words of the current query, which bounds the memory used
+void ItemSorter::prepareWordScores() {
+    const std::vector<QueryWord>& words = m_compiledQuery.words();
+    m_wordColumns.clear();
+    if (words.size() < 2) {
+        m_wordScores.clear();
+        return;
+    }
+
+    std::erase_if(m_wordScores, [&] (const auto& column) {
+        return std::none_of(words.begin(), words.end(),
+                [&] (const QueryWord& word) {
+            return word.text == column.first;
+        });
+    });
+
+    size_t size = (size_t)m_store.numChunks() << ITEM_CHUNK_BITS;
+    for (const QueryWord& word : words) {
+        std::vector<int>& column = m_wordScores[word.text];
+        if (column.size() < size) {
+            column.resize(size, UNKNOWN_SCORE);
+        }
+        m_wordColumns.push_back(column.data());
+    }
+}
+
+int ItemSorter::calcItem(ItemMatcher& matcher, int id, int *scores) {
+    ItemChunk *c = m_store.getChunk(id);
+    int j = ItemStore::getOffset(id);
+    if (m_wordColumns.empty()) {
+        return matcher.calc(c->text[j], c->length[j], c->mask[j]);
+    }
+    for (size_t i = 0; i < m_wordColumns.size(); i++) {
+        scores[i] = m_wordColumns[i][id];
+    }
+    int heuristic = matcher.calc(c->text[j], c->length[j], c->mask[j],
+            scores);
+    for (size_t i = 0; i < m_wordColumns.size(); i++) {
+        m_wordColumns[i][id] = scores[i];
+    }
+    return heuristic;
+}
+
+// each scoring thread keeps its own buffer for word scores and its own best
+// items, which are merged once all threads are done
+struct ScoringWorker {
+    ScoringWorker(int nWords, int k, ItemOrder order)
+        : scores(nWords), top(k, order) {}
+
+    std::vector<int> scores;
+    TopK<int, ItemOrder> top;
+};
+
+void ItemSorter::addTopCandidates(const std::vector<ScoringWorker>& workers) {
+    for (const ScoringWorker& worker : workers) {
+        const std::vector<int>& top = worker.top.values();
+        m_topCandidates.insert(m_topCandidates.end(), top.begin(), top.end());
+    }
+}
+
+// called between scoring batches, while the workers are idle. the best of
+// what was scored so far goes to the ui if it has not been updated for a
+// while, so that a long pass on a big input shows results early
+void ItemSorter::publishProgress(const std::vector<ScoringWorker>& workers,
+        size_t scored)
+{
+    m_passScored += scored;
+    auto now = std::chrono::steady_clock::now();
+    if (m_passScored >= m_passSize || now - m_lastPublish < PUBLISH_INTERVAL) {
+        return;
+    }
+    m_lastPublish = now;
+
+    std::vector<int> top = m_topCandidates;
+    for (const ScoringWorker& worker : workers) {
+        const std::vector<int>& values = worker.top.values();
+        top.insert(top.end(), values.begin(), values.end());
+    }
+    int n = std::min((int)top.size(), m_firstPageSize);
+    std::partial_sort(top.begin(), top.begin() + n, top.end(), order());
+
+    // until the pass is done, only the first page can be scrolled through
+    publishSnapshot(top.data(), n, n, (double)m_passScored / m_passSize);
+}
+
+// heuristics are left alone without a query, so they are reported as 0
+Item ItemSorter::getItem(int id) {
+    Item item = m_store.get(id);
+    if (!m_isSorted) {
+        item.heuristic = 0;
+    }
+    return item;
+}
+
+// the first n of size matches are copied into a new snapshot, which
+// replaces the one the ui reads from
+void ItemSorter::publishSnapshot(const int *ids, int n, int size,
+        double progress)
+{
+    std::shared_ptr<ItemSnapshot> snapshot = std::make_shared<ItemSnapshot>();
+    snapshot->version = ++m_version;
+    snapshot->size = size;
+    snapshot->items.resize(n);
+    for (int i = 0; i < n; i++) {
+        snapshot->items[i] = getItem(ids[i]);
+    }
+    if (progress >= 1) {
+        m_orderVersion = m_version;
+    }
+    m_snapshot = std::move(snapshot);
+    m_dispatch.dispatch(std::make_shared<ItemsSortedEvent>(progress));
 }
 
-int ItemSorter::copyItems(Item *buffer, int idx, int n) {
-    if (idx + n < 256) {
-        if (idx + n > m_firstItemsSize) {
-            n = m_firstItemsSize - idx;
+// scores every item in chunks [start, end)
+// returns false if the query changed before it was done. the chunks then
+// stay unscored, so they are scored again with the next query
+bool ItemSorter::calcChunks(int start, int end) {
+    ItemMatcher matcher(m_compiledQuery);
+    ThreadPool& pool = ThreadPool::instance();
+    std::vector<ScoringWorker> workers(pool.numThreads(),
+            ScoringWorker(m_wordColumns.size(), m_firstPageSize, order()));
+    ItemChunk **chunks = m_store.getChunks();
+    int batch = std::max(1, SCORING_BATCH_SIZE * pool.numThreads()
+            / ITEM_CHUNK_SIZE);
+
+    for (int first = start; first < end; first += batch) {
+        int last = std::min(first + batch, end);
+        pool.run(last - first, 1, [&] (int thread, size_t begin, size_t stop) {
+            ScoringWorker& worker = workers[thread];
+            for (int i = first + (int)begin; i < first + (int)stop; i++) {
+                ItemChunk *c = chunks[i];
+                int base = i << ITEM_CHUNK_BITS;
+                for (int j = 0; j < c->size; j++) {
+                    if (cancelled()) {
+                        return;
+                    }
+                    c->heuristic[j] = calcItem(matcher, base | j,
+                            worker.scores.data());
+                    if (c->heuristic[j] != BAD_HEURISTIC) {
+                        worker.top.add(base | j);
+                    }
+                }
+            }
+        });
+
+        if (cancelled()) {
+            return false;
+        }
+        size_t scored = 0;
+        for (int i = first; i < last; i++) {
+            scored += chunks[i]->size;
         }
-        for (int i = 0; i < n; i++) {
-            buffer[i] = m_firstItems[idx + i];
+        publishProgress(workers, scored);
+    }
+
+    addTopCandidates(workers);
+    return true;
+}
+
+// rescores the items in m_order, and drops the ones that stopped matching
+// returns false if the query changed before it was done. m_order is then
+// left as it was, which is still a superset of the matches
+bool ItemSorter::calcCandidates() {
+    ItemMatcher matcher(m_compiledQuery);
+    ThreadPool& pool = ThreadPool::instance();
+    std::vector<ScoringWorker> workers(pool.numThreads(),
+            ScoringWorker(m_wordColumns.size(), m_firstPageSize, order()));
+
+    size_t batch = (size_t)SCORING_BATCH_SIZE * pool.numThreads();
+
+    for (size_t first = 0; first < m_order.size(); first += batch) {
+        size_t last = std::min(first + batch, m_order.size());
+        pool.run(last - first, CANDIDATE_GRAIN,
+                [&] (int thread, size_t begin, size_t end) {
+            ScoringWorker& worker = workers[thread];
+            for (size_t i = first + begin; i < first + end; i++) {
+                if (cancelled()) {
+                    return;
+                }
+                int id = m_order[i];
+                int heuristic = calcItem(matcher, id, worker.scores.data());
+                m_store.getChunk(id)->heuristic[ItemStore::getOffset(id)]
+                    = heuristic;
+                if (heuristic != BAD_HEURISTIC) {
+                    worker.top.add(id);
+                }
+            }
+        });
+
+        if (cancelled()) {
+            return false;
         }
+        publishProgress(workers, last - first);
+    }
+
+    addTopCandidates(workers);
+    std::erase_if(m_order, [this] (int id) {
+        return m_store.getChunk(id)->heuristic[ItemStore::getOffset(id)]
+            == BAD_HEURISTIC;
+    });
+    return true;
+}
+
+int ItemSorter::copyItems(const ItemSnapshot& snapshot, Item *buffer,
+        int idx, int n)
+{
+    if (idx + n > snapshot.size) {
+        n = std::max(snapshot.size - idx, 0);
+    }
+    int copied = std::clamp((int)snapshot.items.size() - idx, 0, n);
+    for (int i = 0; i < copied; i++) {
+        buffer[i] = snapshot.items[idx + i];
+    }
+    if (copied == n) {
         return n;
     }
 
+    // anything past the snapshot comes from the sorted part of m_order,
+    // which belongs to the sorter thread while it works. the ui never waits
+    // for it: rows which aren't ready are filled with placeholders, and the
+    // sorter is asked to sort them
+    int ready = copied;
+    {
+        std::unique_lock items_lock(m_items_mut, std::try_to_lock);
+        if (items_lock && snapshot.version == m_orderVersion) {
+            ready = std::clamp(m_sortIdx - idx, copied, n);
+            for (int i = copied; i < ready; i++) {
+                buffer[i] = getItem(m_order[idx + i]);
+            }
+        }
+    }
+    if (ready < n) {
+        std::fill(buffer + ready, buffer + n, PLACEHOLDER_ITEM);
+        requestPage(snapshot.version, idx + n);
+    }
+    return n;
+}
+
+// like copyItems for a single item, but sorts on the calling thread instead
+// of handing out a placeholder. this is only used once jfind is quitting,
+// when a pass may have been cancelled before it caught up with the ui's
+// snapshot, so the item is taken from m_order as it is
+// returns false if there is no item at idx
+bool ItemSorter::fetchItem(int idx, Item *item) {
     std::unique_lock items_lock(m_items_mut);
-    if (idx + n > m_items.size()) {
-        n = m_items.size() - idx;
+    if (idx >= (int)m_order.size()) {
+        return false;
     }
+    sort(idx + 1);
+    *item = getItem(m_order[idx]);
+    return true;
+}
 
-    if (idx + n > m_sortIdx) {
-        sort(idx + n);
+void ItemSorter::requestPage(unsigned version, int end) {
+    {
+        std::unique_lock lock(m_sorter_mut);
+        if (version != m_pageVersion) {
+            m_pageVersion = version;
+            m_pageEnd = 0;
+        }
+        m_pageEnd = std::max(m_pageEnd, end);
     }
+    m_sorter_cv.notify_one();
+}
 
-    for (int i = 0; i < n; i++) {
-        buffer[i] = m_items[idx + i];
+// returns true if the ui should read its page again. every request for the
+// current snapshot is answered, even if the page was already sorted, as the
+// ui may have missed it while the sorter held m_items_mut. requests for
+// outdated snapshots are dropped, the ui will ask again once it has the
+// latest one
+bool ItemSorter::sortPage() {
+    int end;
+    unsigned version;
+    {
+        std::unique_lock lock(m_sorter_mut);
+        end = m_pageEnd;
+        version = m_pageVersion;
+        m_pageEnd = 0;
     }
+    if (end == 0 || version != m_orderVersion) {
+        return false;
+    }
+    sort(end);
+    return true;
+}
 
-    return n;
+// picks up a new first page size between passes, so a taller terminal gets
+// its first page sorted without waiting for the next key or batch. returns
+// true if the ui should read its page again
+bool ItemSorter::resizeFirstPage() {
+    {
+        std::unique_lock lock(m_sorter_mut);
+        if (m_nextFirstPageSize == m_firstPageSize) {
+            return false;
+        }
+        m_firstPageSize = m_nextFirstPageSize;
+    }
+    // after a cancelled pass, the next one takes care of it
+    if (m_orderVersion == 0) {
+        return false;
+    }
+    sort(m_firstPageSize);
+    return true;
 }
 
 void ItemSorter::sorterThread() {
-    std::unique_lock items_lock(m_items_mut);
     while (m_sorterThreadActive) {
-        addNewItems();
-        sortItems();
+        // items never move once they are in the store, so new chunks can be
+        // added without holding up the ui
+        bool added = addNewItems();
+        bool resized, pageSorted;
+        {
+            std::unique_lock items_lock(m_items_mut);
+            sortItems(added);
+            resized = resizeFirstPage();
+            pageSorted = sortPage();
+        }
+        // only once m_items_mut is free, so the ui can read the page
+        if (resized || pageSorted) {
+            m_dispatch.dispatch(std::make_shared<PageSortedEvent>());
+        }
         {
             std::unique_lock lock(m_sorter_mut);
-            items_lock.unlock();
-            if (m_sorterThreadActive && !m_queryChanged && !m_hasNewItems) {
+            if (m_sorterThreadActive && !m_queryChanged && !m_hasNewItems
+                    && !m_pageEnd
+                    && m_nextFirstPageSize == m_firstPageSize) {
                 m_sorter_cv.wait(lock);
             }
             else {
                 std::this_thread::yield();
             }
-            items_lock.lock();
         }
     }
 }
@@ -186,14 +694,13 @@ void ItemSorter::onEvent(std::shared_ptr<Event> event) {
             std::unique_lock lock(m_sorter_mut);
             m_newQuery = queryChangeEvent->getQuery();
             m_queryChanged = true;
+            m_epoch++;
             m_sorter_cv.notify_one();
             break;
         }
 
         case NEW_ITEMS_EVENT: {
-            NewItemsEvent *newItemsEvent = (NewItemsEvent*)event.get();
             std::unique_lock lock(m_sorter_mut);
-            m_newItems = newItemsEvent->getItems();
             m_hasNewItems = true;
             m_sorter_cv.notify_one();
             break;
@@ -216,44 +723,64 @@ void ItemSorter::endSorterThread() {
         std::unique_lock lock(m_sorter_mut);
         m_queryChanged = true;
         m_sorterThreadActive = false;
+        m_epoch++;
     }
     m_sorter_cv.notify_one();
     m_sorterThread->join();
     delete m_sorterThread;
 }
 
-void ItemSorter::addNewItems() {
-    std::unique_lock sorter_lock(m_sorter_mut);
-    if (!m_hasNewItems) {
-        return;
+// returns true if any chunks were added
+bool ItemSorter::addNewItems() {
+    {
+        std::unique_lock sorter_lock(m_sorter_mut);
+        m_hasNewItems = false;
     }
-    m_hasNewItems = false;
-    m_items.insert(m_items.end(), m_newItems->data(),
-            m_newItems->data() + m_newItems->size());
-    m_dispatch.dispatch(std::make_shared<ItemsAddedEvent>());
+
+    // the reader may have pushed chunks without waking the sorter yet, so
+    // the queue is always drained
+    bool added = false;
+    ItemChunk *chunk;
+    while (m_queue->pop(&chunk)) {
+        m_store.add(chunk);
+        m_stats.add(chunk);
+        added = true;
+    }
+
+    if (added) {
+        m_dispatch.dispatch(std::make_shared<ItemsAddedEvent>());
+    }
+    return added;
 }
 
-void ItemSorter::sortItems() {
-    bool queryChanged;
+// only runs a pass if the query changed or items were added, so the ui
+// keeps its snapshot (and its cursor) while it is only asking for pages
+void ItemSorter::sortItems(bool itemsAdded) {
     {
         std::unique_lock lock(m_sorter_mut);
-        queryChanged = m_queryChanged;
-        if (queryChanged) {
+        if (!m_queryChanged && !itemsAdded) {
+            return;
+        }
+        if (m_queryChanged) {
             setQuery();
         }
+        m_passEpoch = m_epoch;
+        m_firstPageSize = m_nextFirstPageSize;
     }
 
-    // calc will cancel upon query change
-    // this way, jfind can quickly restart calc with new query
-    calcHeuristics(queryChanged);
+    // the ui can't read deeper pages from m_order until the pass is done
+    m_orderVersion = 0;
 
-    if (!m_queryChanged) {
-        // sort the first few items on the sorter thread. this is to remove the
-        // delay on the main thread, which the user could notice
-        m_firstItemsSize = m_items.size() < 256 ? m_items.size() : 256;
-        sort(m_firstItemsSize);
-        std::copy(m_items.begin(), m_items.begin() + m_firstItemsSize,
-                  m_firstItems);
-        m_dispatch.dispatch(std::make_shared<ItemsSortedEvent>());
+    // the scoring threads give up as soon as the epoch moves on, and the
+    // rest of the pass is skipped. the sorter thread then picks up the new
+    // query straight away, without waiting on the condition variable
+    if (!calcHeuristics()) {
+        return;
     }
+
+    // sort the first few items on the sorter thread. this is to remove the
+    // delay on the main thread, which the user could notice
+    int n = std::min((int)m_order.size(), m_firstPageSize);
+    sort(n);
+    publishSnapshot(m_order.data(), n, m_order.size(), 1);
 }
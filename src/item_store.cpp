@@ -0,0 +1,37 @@
+#include "../include/item_store.hpp"
+#include <cstdlib>
+
+ItemStore::ItemStore() {
+    // the table is only touched as far as it is used
+    m_chunks = (ItemChunk**)calloc(MAX_ITEM_CHUNKS, sizeof(ItemChunk*));
+}
+
+ItemStore::~ItemStore() {
+    for (int i = 0; i < m_numChunks; i++) {
+        delete m_chunks[i];
+    }
+    free(m_chunks);
+}
+
+void ItemStore::add(ItemChunk *chunk) {
+    int n = m_numChunks.load(std::memory_order_relaxed);
+    if (n == MAX_ITEM_CHUNKS) {
+        delete chunk;
+        return;
+    }
+    m_chunks[n] = chunk;
+    m_size.fetch_add(chunk->size, std::memory_order_relaxed);
+    m_numChunks.store(n + 1, std::memory_order_release);
+}
+
+int ItemStore::numChunks() {
+    return m_numChunks.load(std::memory_order_acquire);
+}
+
+ItemChunk** ItemStore::getChunks() {
+    return m_chunks;
+}
+
+int ItemStore::size() {
+    return m_size.load(std::memory_order_relaxed);
+}
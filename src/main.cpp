@@ -13,6 +13,7 @@
 #include "../include/event_dispatch.hpp"
 #include "../include/item_reader.hpp"
 #include "../include/logger.hpp"
+#include "../include/thread_pool.hpp"
 
 #include <thread>
 #include <climits>
@@ -28,10 +29,10 @@ Logger logger = Logger("main");
 void printResult(Item *selected, const char *input) {
     if (selected) {
         if (!config.selectHint || config.selectBoth) {
-            printf("%s\n", selected->text);
+            printf("%.*s\n", selected->length, selected->text);
         }
         if (config.selectHint || config.selectBoth) {
-            printf("%s\n", selected->text + strlen(selected->text) + 1);
+            printf("%.*s\n", selected->hintLength, selected->hint());
         }
     }
     else if (config.acceptNonMatch) {
@@ -104,11 +105,14 @@ void displayHelp(const char *name) {
     printf("OPTIONS:\n");
     printf("    --help                        Display this dialog\n");
     printf("    --hints                       Read hints from stdin (every second line)\n");
+    printf("    --input=FILE                  Read items from FILE instead of stdin (repeatable)\n");
     printf("    --select-hint                 Print the hint to stdout\n");
     printf("    --select-both                 Print both the item and hint to stdout\n");
     printf("    --accept-non-match            Accept the user's query if nothing matches\n");
     printf("    --history=FILE                Read and write match history to FILE\n");
     printf("    --history-limit=INT           Number of items to store in the history file\n");
+    printf("    --query-cache-size=INT        Memory in MiB for results of recent queries\n");
+    printf("    --threads=INT                 Number of threads used for reading and sorting (0: all cores)\n");
     printf("    --prompt=PROMPT               Set the query prompt to PROMPT\n");
     printf("    --query=QUERY                 Set the starting query to QUERY\n");
     printf("\n");
@@ -118,6 +122,8 @@ void displayHelp(const char *name) {
     printf("    prompt: STRING                The default prompt\n");
     printf("    prompt_gap: INT               The distance between the prompt and query\n");
     printf("    history_limit: INT            Default number of items to store in the history file\n");
+    printf("    query_cache_size: INT         Default memory in MiB for results of recent queries\n");
+    printf("    threads: INT                  Default number of threads used for reading and sorting\n");
     printf("    min_hint_spacing: INT         Minimum gap between an item and its hint\n");
     printf("    min_hint_width: INT           Minimum width a hint should be before it is shown\n");
     printf("    max_hint_width: INT           Maximum width a hint can grow to\n");
@@ -167,7 +173,8 @@ int main(int argc, const char **argv) {
         logger.log("--------------");
     }
 
-    if (isatty(STDIN_FILENO) || config.showHelp) {
+    bool hasInput = !isatty(STDIN_FILENO) || config.inputFiles.size();
+    if (!hasInput || config.showHelp) {
         displayHelp(argv[0]);
         return 0;
     }
@@ -181,7 +188,13 @@ int main(int argc, const char **argv) {
         historyManager->readHistory();
     }
 
-    ItemSorter itemSorter;
+    if (config.threads) {
+        ThreadPool::instance().setNumThreads(config.threads);
+    }
+
+    ItemChunkQueue itemQueue(256);
+    ItemSorter itemSorter(&itemQueue);
+    itemSorter.setQueryCacheLimit((size_t)config.queryCacheSize << 20);
     ItemCache itemCache(&itemSorter);
 
     ItemList itemList(stderr, &styleManager, &itemCache);
@@ -199,8 +212,14 @@ int main(int argc, const char **argv) {
     // enable unicode
     setlocale(LC_ALL, "en_US.UTF-8");
 
-    ItemReader itemReader(stdin);
+    ItemReader itemReader(STDIN_FILENO, &itemQueue);
     itemReader.setReadHints(config.showHints);
+    for (const std::string& file : config.inputFiles) {
+        if (!itemReader.addInputFile(expandUserPath(file))) {
+            fprintf(stderr, "ERROR: '%s' could not be read\n", file.c_str());
+            return 1;
+        }
+    }
 
     ansi.setOutputFile(stderr);
 
@@ -0,0 +1,51 @@
+#include "../include/mapped_file.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+}
+
+bool MappedFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // the mapping stays valid after the descriptor is closed
+    bool success = open(fd);
+    close(fd);
+    return success;
+}
+
+bool MappedFile::open(int fileDescriptor) {
+    struct stat st;
+    if (fstat(fileDescriptor, &st) || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+
+    m_size = st.st_size;
+    if (m_size) {
+        void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE,
+                fileDescriptor, 0);
+        if (data == MAP_FAILED) {
+            m_size = 0;
+            return false;
+        }
+        m_data = (char*)data;
+        madvise(m_data, m_size, MADV_SEQUENTIAL);
+    }
+
+    return true;
+}
+
+const char* MappedFile::data() {
+    return m_data;
+}
+
+size_t MappedFile::size() {
+    return m_size;
+}
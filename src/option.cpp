@@ -56,6 +56,22 @@ bool StringOption::parse(const char *value) {
 }
 
 
+StringListOption::StringListOption(std::string key,
+        std::vector<std::string> *values)
+{
+    m_key = key;
+    m_values = values;
+}
+
+bool StringListOption::parse(const char *value) {
+    if (!value || strlen(value) == 0) {
+        return error("expects a value");
+    }
+    m_values->push_back(value);
+    return true;
+}
+
+
 IntegerOption::IntegerOption(std::string key, int *value) {
     m_key = key;
     m_value = value;
@@ -0,0 +1,57 @@
+#include "../include/query_cache.hpp"
+
+void QueryCache::setLimit(size_t bytes) {
+    m_limit = bytes;
+    evict(0);
+}
+
+size_t QueryCache::entrySize(const std::string& query, size_t n) {
+    return sizeof(QueryCacheEntry) + query.size() + n * 2 * sizeof(int);
+}
+
+void QueryCache::evict(size_t size) {
+    while (!m_entries.empty() && m_size + size > m_limit) {
+        QueryCacheEntry& entry = m_entries.back();
+        m_size -= entrySize(entry.query, entry.ids.size());
+        m_index.erase(entry.query);
+        m_entries.pop_back();
+    }
+}
+
+void QueryCache::put(const std::string& query, int chunks, int sorted,
+                     ItemStore& store, const std::vector<int>& ids)
+{
+    auto it = m_index.find(query);
+    if (it != m_index.end()) {
+        m_size -= entrySize(query, it->second->ids.size());
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+
+    size_t size = entrySize(query, ids.size());
+    if (size > m_limit) {
+        return;
+    }
+    evict(size);
+
+    QueryCacheEntry entry = {query, chunks, sorted, ids, {}};
+    entry.heuristics.reserve(ids.size());
+    for (int id : ids) {
+        entry.heuristics.push_back(
+                store.getChunk(id)->heuristic[ItemStore::getOffset(id)]);
+    }
+    m_entries.push_front(std::move(entry));
+    m_index[query] = m_entries.begin();
+    m_size += size;
+}
+
+const QueryCacheEntry* QueryCache::find(const std::string& query) {
+    for (int n = query.size(); n >= 0; n--) {
+        auto it = m_index.find(query.substr(0, n));
+        if (it != m_index.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return &*it->second;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,80 @@
+#include "../include/radix_sort.hpp"
+#include "../include/thread_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+// a slice is only worth giving to another thread with this many keys
+const size_t RADIX_SLICE_SIZE = 1 << 16;
+
+typedef std::array<size_t, 256> Counts;
+
+static void runSlices(int nSlices, std::function<void(int)> f) {
+    ThreadPool::instance().run(nSlices, 1,
+            [&] (int, size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; slice++) {
+            f(slice);
+        }
+    });
+}
+
+void radixSort(uint64_t *keys, int *values, size_t n, int bits) {
+    int nSlices = std::clamp<size_t>(n / RADIX_SLICE_SIZE, 1,
+            ThreadPool::instance().numThreads());
+    std::vector<uint64_t> keyBuffer(n);
+    std::vector<int> valueBuffer(n);
+    std::vector<Counts> counts(nSlices);
+
+    uint64_t *srcKeys = keys;
+    uint64_t *dstKeys = keyBuffer.data();
+    int *srcValues = values;
+    int *dstValues = valueBuffer.data();
+
+    auto sliceBegin = [&] (int slice) {
+        return n * slice / nSlices;
+    };
+
+    for (int shift = 0; shift < bits; shift += 8) {
+        runSlices(nSlices, [&] (int slice) {
+            Counts& count = counts[slice];
+            count.fill(0);
+            for (size_t i = sliceBegin(slice); i < sliceBegin(slice + 1); i++) {
+                count[(srcKeys[i] >> shift) & 0xff]++;
+            }
+        });
+
+        // each slice writes its keys for a byte after those of the slices
+        // before it, which keeps the sort stable
+        size_t offset = 0;
+        bool same = false;
+        for (int digit = 0; digit < 256; digit++) {
+            size_t start = offset;
+            for (Counts& count : counts) {
+                size_t c = count[digit];
+                count[digit] = offset;
+                offset += c;
+            }
+            same |= offset - start == n;
+        }
+        if (same) {
+            continue;
+        }
+
+        runSlices(nSlices, [&] (int slice) {
+            Counts& offsets = counts[slice];
+            for (size_t i = sliceBegin(slice); i < sliceBegin(slice + 1); i++) {
+                size_t& dst = offsets[(srcKeys[i] >> shift) & 0xff];
+                dstKeys[dst] = srcKeys[i];
+                dstValues[dst] = srcValues[i];
+                dst++;
+            }
+        });
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
+    }
+
+    if (srcValues != values) {
+        memcpy(values, srcValues, n * sizeof(int));
+    }
+}
@@ -0,0 +1,217 @@
+#include "../include/simd.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+static const char* findNewlineScalar(const char *begin, const char *end) {
+    return (const char*)memchr(begin, '\n', end - begin);
+}
+
+static size_t countNewlinesScalar(const char *begin, const char *end) {
+    size_t count = 0;
+    for (const char *p = begin; p < end; p++) {
+        count += *p == '\n';
+    }
+    return count;
+}
+
+static bool isSubsequenceScalar(const char *begin, const char *end,
+                                const char *query)
+{
+    for (const char *p = begin; *query && p < end; p++) {
+        char c = *p >= 'A' && *p <= 'Z' ? *p + 32 : *p;
+        query += c == *query;
+    }
+    return !*query;
+}
+
+#ifdef SIMD_X86
+
+__attribute__((target("sse2")))
+static const char* findNewlineSse2(const char *begin, const char *end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const char *p = begin;
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findNewlineScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* findNewlineAvx2(const char *begin, const char *end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const char *p = begin;
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return findNewlineSse2(p, end);
+}
+
+__attribute__((target("sse2,popcnt")))
+static size_t countNewlinesSse2(const char *begin, const char *end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const char *p = begin;
+    size_t count = 0;
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)p);
+        count += __builtin_popcount(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+        p += 16;
+    }
+    return count + countNewlinesScalar(p, end);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t countNewlinesAvx2(const char *begin, const char *end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const char *p = begin;
+    size_t count = 0;
+    while (end - p >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)p);
+        count += __builtin_popcount(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+        p += 32;
+    }
+    return count + countNewlinesSse2(p, end);
+}
+
+// the subsequence kernels fold a block to lowercase, then look for the
+// current query character in it. several query characters can be found in
+// the same block, so bits before the last match are masked out
+
+__attribute__((target("sse2")))
+static inline __m128i foldSse2(__m128i block) {
+    __m128i upper = _mm_and_si128(
+            _mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)),
+            _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+__attribute__((target("sse2")))
+static bool isSubsequenceSse2(const char *begin, const char *end,
+                              const char *query)
+{
+    const char *p = begin;
+    while (*query && end - p >= 16) {
+        __m128i block = foldSse2(_mm_loadu_si128((const __m128i*)p));
+        unsigned skip = 0;
+        while (*query) {
+            unsigned mask = _mm_movemask_epi8(
+                    _mm_cmpeq_epi8(block, _mm_set1_epi8(*query)));
+            mask = skip < 16 ? mask & (0xffffu << skip) : 0;
+            if (!mask) {
+                break;
+            }
+            skip = __builtin_ctz(mask) + 1;
+            query++;
+        }
+        p += 16;
+    }
+    return isSubsequenceScalar(p, end, query);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i foldAvx2(__m256i block) {
+    __m256i upper = _mm256_and_si256(
+            _mm256_cmpgt_epi8(block, _mm256_set1_epi8('A' - 1)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), block));
+    return _mm256_or_si256(block,
+            _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static bool isSubsequenceAvx2(const char *begin, const char *end,
+                              const char *query)
+{
+    const char *p = begin;
+    while (*query && end - p >= 32) {
+        __m256i block = foldAvx2(_mm256_loadu_si256((const __m256i*)p));
+        unsigned skip = 0;
+        while (*query) {
+            unsigned mask = _mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(block, _mm256_set1_epi8(*query)));
+            mask = skip < 32 ? mask & (0xffffffffu << skip) : 0;
+            if (!mask) {
+                break;
+            }
+            skip = __builtin_ctz(mask) + 1;
+            query++;
+        }
+        p += 32;
+    }
+    return isSubsequenceSse2(p, end, query);
+}
+
+#endif
+
+typedef const char* (*FindNewlineFunc)(const char*, const char*);
+
+static FindNewlineFunc pickFindNewline() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findNewlineAvx2;
+    }
+    return findNewlineSse2;
+#else
+    return findNewlineScalar;
+#endif
+}
+
+typedef size_t (*CountNewlinesFunc)(const char*, const char*);
+
+static CountNewlinesFunc pickCountNewlines() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return countNewlinesAvx2;
+    }
+    if (__builtin_cpu_supports("popcnt")) {
+        return countNewlinesSse2;
+    }
+#endif
+    return countNewlinesScalar;
+}
+
+typedef bool (*IsSubsequenceFunc)(const char*, const char*, const char*);
+
+static IsSubsequenceFunc pickIsSubsequence() {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return isSubsequenceAvx2;
+    }
+    return isSubsequenceSse2;
+#else
+    return isSubsequenceScalar;
+#endif
+}
+
+static const FindNewlineFunc findNewlineImpl = pickFindNewline();
+static const CountNewlinesFunc countNewlinesImpl = pickCountNewlines();
+static const IsSubsequenceFunc isSubsequenceImpl = pickIsSubsequence();
+
+const char* findNewline(const char *begin, const char *end) {
+    return findNewlineImpl(begin, end);
+}
+
+size_t countNewlines(const char *begin, const char *end) {
+    return countNewlinesImpl(begin, end);
+}
+
+bool isSubsequence(const char *begin, const char *end, const char *query) {
+    return isSubsequenceImpl(begin, end, query);
+}
@@ -1,4 +1,5 @@
 #include "../include/spinner.hpp"
+#include <algorithm>
 
 using namespace std::chrono_literals;
 using std::chrono::milliseconds;
@@ -7,6 +8,9 @@ using std::chrono::system_clock;
 const char *SPINNER[6] = {"⠇", "⠋", "⠙", "⠸", "⠴", "⠦"};
 const int SPINNER_SIZE = 6;
 
+const char *PROGRESS[8] = {"⡀", "⡄", "⡆", "⡇", "⣇", "⣧", "⣷", "⣿"};
+const int PROGRESS_SIZE = 8;
+
 Spinner::Spinner(FILE *file) {
     m_outputFile = file;
 }
@@ -39,7 +43,14 @@ void Spinner::update() {
 void Spinner::draw() {
     if (m_firstUpdateComplete) {
         ansi.move(m_x, m_y);
-        fprintf(m_outputFile, "%s", SPINNER[m_frame]);
+        if (m_progress > 0 && m_progress < 1) {
+            int i = std::min((int)(m_progress * PROGRESS_SIZE),
+                    PROGRESS_SIZE - 1);
+            fprintf(m_outputFile, "%s", PROGRESS[i]);
+        }
+        else {
+            fprintf(m_outputFile, "%s", SPINNER[m_frame]);
+        }
     }
 }
 
@@ -55,3 +66,7 @@ void Spinner::setSpinning(bool value) {
     }
     m_isSpinning = value;
 }
+
+void Spinner::setProgress(double progress) {
+    m_progress = progress;
+}
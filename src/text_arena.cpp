@@ -0,0 +1,71 @@
+#include "../include/text_arena.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+TextArena::~TextArena() {
+    for (char *block : m_blocks) {
+        free(block);
+    }
+}
+
+void TextArena::newBlock(size_t size, size_t keep) {
+    // a line longer than a block grows it geometrically, so a very long
+    // line is copied a logarithmic number of times
+    size = std::max({size, 2 * keep, TEXT_ARENA_BLOCK_SIZE});
+
+    // nothing has been committed to the current block yet, so nothing
+    // points into it and it can be resized instead of abandoned
+    if (m_blocks.size() && m_ptr == m_blocks.back()) {
+        char *block;
+        if (keep) {
+            block = (char*)realloc(m_blocks.back(), size);
+        } else {
+            free(m_blocks.back());
+            block = (char*)malloc(size);
+        }
+        if (!block) {
+            abort();
+        }
+        m_blocks.back() = block;
+        m_ptr = block;
+        m_end = block + size;
+        return;
+    }
+
+    char *block = (char*)malloc(size);
+    if (!block) {
+        abort();
+    }
+    if (keep) {
+        memcpy(block, m_ptr, keep);
+    }
+    m_blocks.push_back(block);
+    m_ptr = block;
+    m_end = block + size;
+}
+
+char* TextArena::alloc(size_t size) {
+    reserve(size, 0);
+    char *ptr = m_ptr;
+    m_ptr += size;
+    return ptr;
+}
+
+char* TextArena::tail() {
+    return m_ptr;
+}
+
+size_t TextArena::available() {
+    return m_end - m_ptr;
+}
+
+void TextArena::commit(size_t size) {
+    m_ptr += size;
+}
+
+void TextArena::reserve(size_t size, size_t keep) {
+    if (available() < size) {
+        newBlock(size, keep);
+    }
+}
@@ -0,0 +1,134 @@
+#include "../include/thread_pool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool() {
+    m_nThreads = std::max(1u, std::thread::hardware_concurrency());
+    startThreads();
+}
+
+// the pool is never destroyed, as jfind may exit while a job is running
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool *singleton = new ThreadPool;
+    return *singleton;
+}
+
+void ThreadPool::setNumThreads(int n) {
+    std::unique_lock runLock(m_runMutex);
+    stopThreads();
+    m_nThreads = std::max(1, n);
+    startThreads();
+}
+
+int ThreadPool::numThreads() {
+    return m_nThreads;
+}
+
+void ThreadPool::startThreads() {
+    m_stop = false;
+    for (int i = 1; i < m_nThreads; i++) {
+        m_threads.emplace_back(&ThreadPool::workerThread, this, i);
+    }
+}
+
+void ThreadPool::stopThreads() {
+    {
+        std::unique_lock lock(m_mutex);
+        m_stop = true;
+    }
+    m_workCv.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+// set on the pool's workers, and on a caller while its job runs
+static thread_local bool t_working = false;
+
+void ThreadPool::run(size_t n, size_t grain, Task task) {
+    if (n == 0) {
+        return;
+    }
+    grain = std::max(grain, (size_t)1);
+    if (t_working) {
+        task(0, 0, n);
+        return;
+    }
+
+    std::shared_lock runLock(m_runMutex);
+    t_working = true;
+    if (m_nThreads == 1 || n <= grain) {
+        task(0, 0, n);
+        t_working = false;
+        return;
+    }
+
+    Job job;
+    job.task = std::move(task);
+    job.grain = grain;
+    job.ranges.reset(new Range[m_nThreads]);
+    for (int i = 0; i < m_nThreads; i++) {
+        job.ranges[i].next = n * i / m_nThreads;
+        job.ranges[i].end = n * (i + 1) / m_nThreads;
+    }
+    {
+        std::unique_lock lock(m_mutex);
+        m_jobs.push_back(&job);
+    }
+    m_workCv.notify_all();
+
+    work(job, 0);
+
+    // every grain has been handed out, but workers may still be working
+    // on the last ones
+    {
+        std::unique_lock lock(m_mutex);
+        job.exhausted = true;
+        m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+        m_doneCv.wait(lock, [&] { return job.active == 0; });
+    }
+    t_working = false;
+}
+
+// workers help with the oldest job that still has grains to hand out
+void ThreadPool::workerThread(int thread) {
+    t_working = true;
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        Job *job = nullptr;
+        m_workCv.wait(lock, [&] {
+            for (Job *j : m_jobs) {
+                if (!j->exhausted) {
+                    job = j;
+                    return true;
+                }
+            }
+            return m_stop;
+        });
+        if (!job) {
+            return;
+        }
+        job->active++;
+        lock.unlock();
+        work(*job, thread);
+        lock.lock();
+        job->exhausted = true;
+        if (--job->active == 0) {
+            m_doneCv.notify_all();
+        }
+    }
+}
+
+// a thread starts with its own range, then moves on to the others
+void ThreadPool::work(Job& job, int thread) {
+    for (int i = 0; i < m_nThreads; i++) {
+        Range& range = job.ranges[(thread + i) % m_nThreads];
+        while (true) {
+            size_t begin = range.next.fetch_add(job.grain);
+            if (begin >= range.end) {
+                break;
+            }
+            job.task(thread, begin, std::min(begin + job.grain, range.end));
+        }
+    }
+}
@@ -24,6 +24,7 @@ UserInterface::UserInterface(FILE *outputFile, StyleManager *styleManager, ItemL
     m_dispatch.subscribe(this, QUIT_EVENT);
     m_dispatch.subscribe(this, RESIZE_EVENT);
     m_dispatch.subscribe(this, ITEMS_SORTED_EVENT);
+    m_dispatch.subscribe(this, PAGE_SORTED_EVENT);
     m_dispatch.subscribe(this, ALL_ITEMS_READ_EVENT);
 }
 
@@ -184,6 +185,7 @@ void UserInterface::handleInput(KeyEvent event) {
     }
     if (m_editor->getText() != query) {
         m_isSorting = true;
+        m_spinner.setProgress(0);
         m_dispatch.dispatch(std::make_shared<QueryChangeEvent>(m_editor->getText()));
     }
 
@@ -208,10 +210,19 @@ void UserInterface::onEvent(std::shared_ptr<Event> event) {
             break;
         }
         case ITEMS_SORTED_EVENT: {
-            m_isSorting = false;
+            // results can come in before the sorter is done with them
+            ItemsSortedEvent *itemsSortedEvent
+                    = (ItemsSortedEvent*)event.get();
+            double progress = itemsSortedEvent->getProgress();
+            m_isSorting = progress < 1;
+            m_spinner.setProgress(progress);
             m_requiresRefresh = true;
             break;
         }
+        case PAGE_SORTED_EVENT: {
+            m_requiresReload = true;
+            break;
+        }
         case ALL_ITEMS_READ_EVENT: {
             m_itemList->allowScrolling(true);
             m_isReading = false;
@@ -242,6 +253,11 @@ void UserInterface::onLoop() {
     if (m_requiresRefresh) {
         m_itemList->refresh();
         m_requiresRefresh = false;
+        m_requiresReload = false;
+    }
+    if (m_requiresReload) {
+        m_itemList->reload();
+        m_requiresReload = false;
     }
 
     milliseconds remaining = m_spinner.frameTimeRemaining();